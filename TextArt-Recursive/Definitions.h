@@ -68,6 +68,17 @@ void menuTwo(char canvas[][MAXCOLS], char backupCanvas[][MAXCOLS], bool& animate
 */
 void fillRecursive(char canvas[][MAXCOLS], int row, int col, char oldCh, char newCh, bool animate);
 
+/*
+* Fills the area around row, col with newCh, like fillRecursive with the
+* character found at row, col as oldCh. Each run of such cells in a row is
+* filled at once, and the runs still to visit are kept on the heap instead
+* of in recursive calls.
+* diagonal - true: the area also spreads through the corners of cells
+*   (8 neighbours) / false: only up, down, left and right (4 neighbours)
+* animate - true: animate, one run after another / false: no animation
+*/
+void fillScanline(char canvas[][MAXCOLS], int row, int col, char newCh, bool diagonal, bool animate);
+
 /*
 * Stores character ch into canvas at location p
 * p is the Point(row, col) where the character is to be stored
@@ -139,6 +150,40 @@ void drawLineFillRow(char canvas[][MAXCOLS], int col, int startRow, int endRow,
 
 
 
+//--------------------Terminal Functions----------------------------------------------------------------
+
+/*
+* Reads one key without echo, the way _getch does on Windows: an arrow key
+* is returned as SPECIAL, followed by its arrow code on the next call.
+*/
+char getKey();
+
+/*
+* Starts and ends reading single keys without echo. Calls may be nested;
+* getKey uses them itself, so they are only needed around a whole input loop.
+*/
+void beginKeyInput();
+void endKeyInput();
+
+/*
+* Clears the whole screen and moves the cursor to the top left corner.
+*/
+void clearScreen();
+
+/*
+* Shows "Press any key to continue . . ." and waits until any key is pressed.
+*/
+void waitForKey();
+
+/*
+* Shows everything written so far, then waits for a number of milliseconds.
+*/
+void pauseFor(int milliseconds);
+
+
+
+
+
 //--------------------Old Functions---------------------------------------------------------------------
 
 /*
@@ -1,6 +1,8 @@
 #include <iostream>
-#include <windows.h>
-#include <conio.h>
+#include <cctype>
+#include <cstring>
+#include <cmath>
+#include <vector>
 #include "Definitions.h"
 using namespace std;
 
@@ -38,7 +40,7 @@ void drawHelper(char canvas[][MAXCOLS], Point p, char ch, bool animate)
 		{
 			gotoxy(p.row, p.col);
 			printf("%c", ch);
-			Sleep(TIME);
+			pauseFor(TIME);
 		}
 	}
 }
@@ -205,7 +207,11 @@ void menuTwo(char canvas[][MAXCOLS], char backupCanvas[][MAXCOLS], bool& animate
 			menuSelection = getPoint(Start);
 			if (menuSelection != ESC)
 			{
-				fillRecursive(canvas, Start.row, Start.col, canvas[Start.row][Start.col], menuSelection, animate);
+				gotoxy(MAXROWS + 1, 0);
+				clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+				cout << "Fill through corners too? <Y>es / <N>o: ";
+				cin >> pos;
+				fillScanline(canvas, Start.row, Start.col, menuSelection, toupper(pos) == 'Y', animate);
 			}
 			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
 			break;
@@ -302,7 +308,8 @@ char getPoint(Point& pt)
 	int col = 0;
 	//Move cursor to row,col and then get a signle character from the keybaord, so like initialize it 
 	gotoxy(row, col);
-	input = _getch();
+	beginKeyInput();
+	input = getKey();
 
 	//from edit function
 	while (1) 
@@ -312,7 +319,7 @@ char getPoint(Point& pt)
 		if (input == SPECIAL) 
 		{
 
-			input = _getch();
+			input = getKey();
 
 			switch (input) 
 			{
@@ -336,7 +343,7 @@ char getPoint(Point& pt)
 		// Ignore the function keys
 		else if (input == '\0') 
 		{
-			input = _getch();
+			input = getKey();
 		}
 
 		// Printable ASCII characters
@@ -345,16 +352,18 @@ char getPoint(Point& pt)
 			pt.row = row;
 			pt.col = col;
 			cout << input;
+			endKeyInput();
 			return input;
 		}
 
 		else if (input == ESC)
 		{
+			endKeyInput();
 			return ESC;
 		}
 
 		gotoxy(row, col); // Moves cursor to the new position
-		input = _getch(); //get user unput
+		input = getKey(); //get user unput
 	}
 }
 
@@ -367,11 +376,12 @@ void fillRecursive(char canvas[][MAXCOLS], int row, int col, char oldCh, char ne
 	p.col = col;
 
 	// base case: checks if it is outside of the array
-	if (row > MAXROWS || row < 0 || col > MAXCOLS || col < 0)
+	if (row >= MAXROWS || row < 0 || col >= MAXCOLS || col < 0)
 		return;
 
-	// base case: the character at current position is not being replaced
-	if (canvas[row][col] != oldCh)
+	// base case: the character at current position is not being replaced,
+	// or replacing it changes nothing (which would never stop)
+	if (canvas[row][col] != oldCh || oldCh == newCh)
 		return;
 
 	// recursive cases
@@ -383,6 +393,66 @@ void fillRecursive(char canvas[][MAXCOLS], int row, int col, char oldCh, char ne
 }
 
 
+// Fill the area around a point one run of cells at a time
+void fillScanline(char canvas[][MAXCOLS], int row, int col, char newCh, bool diagonal, bool animate)
+{
+	if (row >= MAXROWS || row < 0 || col >= MAXCOLS || col < 0 || canvas[row][col] == newCh)
+		return;
+
+	char oldCh = canvas[row][col];
+	int reach = diagonal ? 1 : 0;
+
+	// Cells to fill from, kept on the heap instead of in recursive calls
+	vector<Point> seeds;
+	seeds.push_back(Point(row, col));
+
+	while (!seeds.empty())
+	{
+		Point seed = seeds.back();
+		seeds.pop_back();
+
+		// Another run may have filled this one already
+		char* cells = canvas[seed.row];
+		if (cells[seed.col] != oldCh)
+			continue;
+
+		// Widen the seed to the whole run of oldCh around it and fill that
+		int left = seed.col;
+		int right = seed.col;
+		while (left > 0 && cells[left - 1] == oldCh)
+			left--;
+		while (right < MAXCOLS - 1 && cells[right + 1] == oldCh)
+			right++;
+
+		if (animate)
+		{
+			for (int x = left; x <= right; x++)
+				drawHelper(canvas, Point(seed.row, x), newCh, animate);
+		}
+		else
+		{
+			memset(cells + left, newCh, right - left + 1);
+		}
+
+		// Each run of oldCh touching this one in the rows above and below,
+		// corners too if diagonal, gets one seed
+		int first = left - reach < 0 ? 0 : left - reach;
+		int last = right + reach > MAXCOLS - 1 ? MAXCOLS - 1 : right + reach;
+		for (int next = seed.row - 1; next <= seed.row + 1; next += 2)
+		{
+			if (next < 0 || next >= MAXROWS)
+				continue;
+
+			for (int x = first; x <= last; x++)
+			{
+				if (canvas[next][x] == oldCh && (x == first || canvas[next][x - 1] != oldCh))
+					seeds.push_back(Point(next, x));
+			}
+		}
+	}
+}
+
+
 // Recursively draw a tree
 void treeRecursive(char canvas[][MAXCOLS], DrawPoint start, int height, int startAngle, int branchAngle, bool animate)
 {
@@ -0,0 +1,282 @@
+#define NOMINMAX
+
+#include <iostream>
+#include <cstdio>
+#include "Definitions.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h>
+#else
+#include <csignal>
+#include <cstdlib>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#endif
+
+using namespace std;
+
+
+// Number of beginKeyInput calls which have not been matched by endKeyInput yet
+static int keyInputDepth = 0;
+
+
+//--------------------Windows console backend-----------------------------------------------------------
+#ifdef _WIN32
+
+// _getch already reads single keys without echo
+static void setKeyInput(bool enabled)
+{
+}
+
+
+char getKey()
+{
+	beginKeyInput();
+	char key = (char)_getch();
+	endKeyInput();
+	return key;
+}
+
+
+void pauseFor(int milliseconds)
+{
+	fflush(stdout);
+	Sleep(milliseconds);
+}
+
+
+void gotoxy(short row, short col)
+{
+	// Whatever is still buffered belongs at the old position
+	fflush(stdout);
+	COORD pos = { col, row };
+	SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), pos);
+}
+
+
+void clearScreen()
+{
+	system("cls");
+}
+
+
+//--------------------POSIX terminal backend------------------------------------------------------------
+#else
+
+// Terminal settings to restore when key input ends
+static termios savedSettings;
+
+// A key code which getKey still has to return; -1 if none
+static int pendingKey = -1;
+
+// Time to wait for the rest of an escape sequence after ESC (in milliseconds)
+const int ESCAPEWAIT = 30;
+
+
+// Restores the terminal if the program ends during key input
+static void restoreTerminal()
+{
+	if (keyInputDepth > 0)
+		tcsetattr(STDIN_FILENO, TCSANOW, &savedSettings);
+}
+
+
+// Restores the terminal when a signal ends the program, which skips atexit,
+// then lets the signal end it as it would have
+static void restoreOnSignal(int signalNumber)
+{
+	tcsetattr(STDIN_FILENO, TCSANOW, &savedSettings);
+	signal(signalNumber, SIG_DFL);
+	raise(signalNumber);
+}
+
+
+// Switches the terminal between line input and single-key input without echo
+static void setKeyInput(bool enabled)
+{
+	if (!isatty(STDIN_FILENO))
+		return;
+
+	if (enabled)
+	{
+		tcgetattr(STDIN_FILENO, &savedSettings);
+
+		// Registered once there are settings to restore
+		static bool registered = false;
+		if (!registered)
+		{
+			atexit(restoreTerminal);
+			signal(SIGINT, restoreOnSignal);
+			signal(SIGTERM, restoreOnSignal);
+			signal(SIGHUP, restoreOnSignal);
+			registered = true;
+		}
+
+		termios raw = savedSettings;
+		raw.c_lflag &= ~(ICANON | ECHO);
+		raw.c_cc[VMIN] = 1;
+		raw.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+	}
+	else
+	{
+		tcsetattr(STDIN_FILENO, TCSANOW, &savedSettings);
+	}
+}
+
+
+// Reads one byte, waiting at most timeout milliseconds (-1: no limit); returns -1 if none
+static int readByte(int timeout)
+{
+	pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+	if (poll(&fd, 1, timeout) <= 0)
+		return -1;
+
+	unsigned char ch;
+	if (read(STDIN_FILENO, &ch, 1) != 1)
+		return -1;
+	return ch;
+}
+
+
+/*
+* Reads keys the way _getch does on Windows: an arrow key is returned as
+* SPECIAL followed by its arrow code on the next call, other special keys
+* as '\0' followed by a code which is ignored.
+*/
+char getKey()
+{
+	if (pendingKey >= 0)
+	{
+		char key = (char)pendingKey;
+		pendingKey = -1;
+		return key;
+	}
+
+	// Everything drawn since the last key reaches the screen in one write
+	fflush(stdout);
+
+	beginKeyInput();
+	int key = readByte(-1);
+
+	// Input closed or failed; treat it like ESC so input loops end
+	if (key < 0)
+		key = ESC;
+
+	// An escape sequence follows ESC immediately; a lone ESC is the key itself
+	if (key == ESC)
+	{
+		int next = readByte(ESCAPEWAIT);
+		if (next == '[' || next == 'O')
+		{
+			// Read up to the final byte of the sequence
+			int last = readByte(ESCAPEWAIT);
+			while (last >= 0 && (last < 0x40 || last > 0x7E))
+				last = readByte(ESCAPEWAIT);
+
+			key = '\0';
+			pendingKey = 0;
+			switch (last)
+			{
+			case 'A': key = SPECIAL; pendingKey = UPARROW; break;
+			case 'B': key = SPECIAL; pendingKey = DOWNARROW; break;
+			case 'C': key = SPECIAL; pendingKey = RIGHTARROW; break;
+			case 'D': key = SPECIAL; pendingKey = LEFTARROW; break;
+			}
+		}
+		else if (next >= 0)
+		{
+			// Alt + key; keep the key for the next call
+			pendingKey = next;
+		}
+	}
+	endKeyInput();
+
+	return (char)key;
+}
+
+
+void pauseFor(int milliseconds)
+{
+	fflush(stdout);
+
+	timespec time;
+	time.tv_sec = milliseconds / 1000;
+	time.tv_nsec = (milliseconds % 1000) * 1000000L;
+	nanosleep(&time, NULL);
+}
+
+
+/*
+* The escape sequence stays in the stdout buffer with the text around it,
+* so a whole step of drawing is sent together when the program next waits.
+*/
+void gotoxy(short row, short col)
+{
+	// ANSI cursor position is 1-based
+	printf("\x1b[%d;%dH", row + 1, col + 1);
+}
+
+
+void clearScreen()
+{
+	printf("\x1b[2J\x1b[H");
+}
+
+#endif
+
+
+/**
+* Starts reading single keys without echo. Calls may be nested;
+* line input comes back when the outermost endKeyInput is called.
+*/
+void beginKeyInput()
+{
+	if (keyInputDepth++ == 0)
+		setKeyInput(true);
+}
+
+
+/**
+* Ends reading single keys.
+*/
+void endKeyInput()
+{
+	if (keyInputDepth > 0 && --keyInputDepth == 0)
+		setKeyInput(false);
+}
+
+
+/**
+* Shows the message system("pause") shows and waits until any key is pressed.
+*/
+void waitForKey()
+{
+	printf("Press any key to continue . . .");
+	getKey();
+	printf("\n");
+}
+
+
+/**
+* Clears a line on the output screen, then resets the cursor back to the
+* beginning of this line.
+*
+* @param lineNum Line number on the output screen to clear
+* @param numOfChars Number of characters to clear on this line
+*/
+void clearLine(int lineNum, int numOfChars)
+{
+	// Move cursor to the beginning of the specified line on the console
+	gotoxy(lineNum, 0);
+
+	// Write a specified number of spaces to overwrite characters
+	for (int x = 0; x < numOfChars; x++)
+		cout << " ";
+
+	// Move cursor back to the beginning of the line
+	gotoxy(lineNum, 0);
+}
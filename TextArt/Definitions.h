@@ -0,0 +1,54 @@
+#pragma once
+
+// ASCII codes for special keys; for editing
+const char ESC = 27;
+const char LEFTARROW = 75;
+const char UPARROW = 72;
+const char RIGHTARROW = 77;
+const char DOWNARROW = 80;
+const char SPECIAL = (char)224;
+
+
+//--------------------Terminal Functions----------------------------------------------------------------
+
+/*
+* Reads one key without echo, the way _getch does on Windows: an arrow key
+* is returned as SPECIAL, followed by its arrow code on the next call.
+*/
+char getKey();
+
+/*
+* Starts and ends reading single keys without echo. Calls may be nested;
+* getKey uses them itself, so they are only needed around a whole input loop.
+*/
+void beginKeyInput();
+void endKeyInput();
+
+/*
+* Clears the whole screen and moves the cursor to the top left corner.
+*/
+void clearScreen();
+
+/*
+* Shows "Press any key to continue . . ." and waits until any key is pressed.
+*/
+void waitForKey();
+
+/*
+* Shows everything written so far, then waits for a number of milliseconds.
+*/
+void pauseFor(int milliseconds);
+
+/*
+* Clears a line on the output screen, then resets the cursor back to the
+* beginning of this line.
+* lineNum is the line number on the output screen to clear
+* numOfChars is the number of characters to clear on this line
+*/
+void clearLine(int lineNum, int numOfChars);
+
+/*
+* Moves the cursor in the output window to a specified row and column.
+* The next output produced by the program will begin at this position.
+*/
+void gotoxy(short row, short col);
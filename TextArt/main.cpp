@@ -7,8 +7,9 @@
 #include <iostream>
 #include <fstream>
 #include <cctype>
-#include <windows.h>
-#include <conio.h>
+#include <cstring>
+#include <limits>
+#include "Definitions.h"
 using namespace std;
 
 const int BUFFERSIZE = 20;
@@ -16,14 +17,6 @@ const int FILENAMESIZE = 255;
 const int MAXROWS = 22;
 const int MAXCOLS = 80;
 
-// ASCII codes for special keys; for editing
-const char ESC = 27;
-const char LEFTARROW = 75;
-const char UPARROW = 72;
-const char RIGHTARROW = 77;
-const char DOWNARROW = 80;
-const char SPECIAL = (char)224;
-
 /*
 * Gets a filename from the user. If file can be opened for reading,
 * this function loads the file's contents into canvas.
@@ -79,20 +72,6 @@ void replace(char canvas[][MAXCOLS], char oldCh, char newCh);
 */
 void moveCanvas(char canvas[][MAXCOLS], int rowValue, int colValue);
 
-/*
-* Clears a line on the output screen, then resets the cursor back to the
-* beginning of this line.
-* lineNum is the line number on the output screen to clear
-* numOfChars is the number of characters to clear on this line
-*/
-void clearLine(int lineNum, int numOfChars);
-
-/*
-* Moves the cursor in the output window to a specified row and column.
-* The next output produced by the program will begin at this position.
-*/
-void gotoxy(short row, short col);
-
 // TODO: Fix the problem with quitting the program
 // TODO: Fix the '|' sign going weird places (maybe problem with displayCanvas
 // or initCanvas?)
@@ -173,41 +152,6 @@ int main()
 }
 
 
-/**
-* Moves the cursor in the output window to a specified row and column.
-* The next output produced by the program will begin at this position.
-* 
-* @param row Row to move the cursor to
-* @param col Column to move the cursor to
-*/
-void gotoxy(short row, short col)
-{
-	COORD pos = { col, row };
-	SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), pos);
-}
-
-
-/**
-* Clears a line on the output screen, then resets the cursor back to the
-* beginning of this line.
-* 
-* @param lineNum Line number on the output screen to clear
-* @param numOfChars Number of characters to clear on this line
-*/
-void clearLine(int lineNum, int numOfChars)
-{
-	// Move cursor to the beginning of the specified line on the console
-	gotoxy(lineNum, 0);
-
-	// Write a specified number of spaces to overwrite characters
-	for (int x = 0; x < numOfChars; x++)
-		cout << " ";
-
-	// Move cursor back to the beginning of the line
-	gotoxy(lineNum, 0);
-}
-
-
 /**
 * Replaces all instances of a character in the canvas.
 * 
@@ -245,14 +189,17 @@ void editCanvas(char canvas[][MAXCOLS])
 	// a single character from the keyboard
 	gotoxy(row, col);
 
+	// Keys typed between two reads must not be echoed onto the canvas
+	beginKeyInput();
+
 	// Get input from user until ESC is pressed
 	while (input != ESC) {
-		input = _getch();
+		input = getKey();
 
 		// Arrow keys
 		if (input == SPECIAL) {
 
-			input = _getch();
+			input = getKey();
 
 			switch (input) {
 			case LEFTARROW:
@@ -274,7 +221,7 @@ void editCanvas(char canvas[][MAXCOLS])
 
 		// Ignore the function keys
 		else if (input == '\0') {
-			input = _getch();
+			input = getKey();
 		}
 
 		// Printable ASCII characters
@@ -283,13 +230,9 @@ void editCanvas(char canvas[][MAXCOLS])
 			cout << input;
 		}
 
-		// Ignore other characters
-		else {
-			input = _getch();
-		}
-
 		gotoxy(row, col); // Moves cursor to the new position
 	}
+	endKeyInput();
 }
 
 
@@ -349,7 +292,7 @@ void initCanvas(char canvas[][MAXCOLS])
 void displayCanvas(char canvas[][MAXCOLS])
 {
 	// Clear the screen
-	system("cls");
+	clearScreen();
 
 	for (int rowCount = 0; rowCount < MAXROWS; rowCount++)
 	{
@@ -415,7 +358,7 @@ void saveCanvas(char canvas[][MAXCOLS])
 
 	//Creates a filpath that we can use to put our filename with the correct directories 
 	char filePath[FILENAMESIZE];
-	snprintf(filePath, FILENAMESIZE, "%s\\%s.txt", directory, fileName);
+	snprintf(filePath, FILENAMESIZE, "%s/%s.txt", directory, fileName);
 
 	//Creates the filepath to be written into
 	ofstream myFile(filePath);
@@ -433,14 +376,14 @@ void saveCanvas(char canvas[][MAXCOLS])
 		//closes the file and lets the user know that the file was saved.
 		myFile.close();
 		cout << "File saved!\n";
-		system("pause");
+		waitForKey();
 
 	}
 	//Outputs an error message if the file cannot be opened.
 	else
 	{
 		cerr << "ERROR: file could not be saved\n";
-		system("pause");
+		waitForKey();
 	}
 		cin.clear();
 		cin.ignore(numeric_limits<streamsize>::max(), '\n');
@@ -460,7 +403,7 @@ void loadCanvas(char canvas[][MAXCOLS])
 	initCanvas(tempCanvas);
 	initCanvas(canvas);
 	char fileLoad[FILENAMESIZE];
-	char preFix[FILENAMESIZE] = "SavedFiles\\";
+	char preFix[FILENAMESIZE] = "SavedFiles/";
 	int length = 0;
 	int lengthP = strlen(preFix);
 
@@ -477,8 +420,7 @@ void loadCanvas(char canvas[][MAXCOLS])
 	// If the file can be found, go to the first position in the file and assigns all the characters
 	if (inFile)
 	{
-		system("cls");
-		gotoxy(0, 0);
+		clearScreen();
 
 		int c = inFile.get();
 		for (int row = 0; row <= MAXROWS + BUFFERSIZE && !inFile.eof();)
@@ -537,6 +479,6 @@ void loadCanvas(char canvas[][MAXCOLS])
 	else
 	{
 		cerr << "ERROR: File cannot be read.\n";
-		system("pause");
+		waitForKey();
 	}
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+* Runs canvas scripts without a terminal, several at a time.
+* Each job list names one script per line; blank lines and lines
+* starting with '#' are skipped. See runScript for the commands.
+*
+* Usage: TextArtBatch [-j threads] joblist...
+*        TextArtBatch [-j threads] -s script...
+*/
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include "Definitions.h"
+using namespace std;
+
+
+// Adds every script named in a job list to scripts; returns false if the list cannot be read
+static bool readJobList(const char* filename, vector<string>& scripts)
+{
+	ifstream jobs(filename);
+	if (!jobs)
+	{
+		return false;
+	}
+
+	string line;
+	while (getline(jobs, line))
+	{
+		size_t start = line.find_first_not_of(" \t\r");
+		size_t end = line.find_last_not_of(" \t\r");
+		if (start == string::npos || line[start] == '#')
+			continue;
+		scripts.push_back(line.substr(start, end - start + 1));
+	}
+	return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+	int threads = (int)thread::hardware_concurrency();
+	bool listsScripts = false;
+	vector<string> scripts;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-s") == 0)
+		{
+			listsScripts = true;
+		}
+		else if (listsScripts)
+		{
+			scripts.push_back(argv[i]);
+		}
+		else if (!readJobList(argv[i], scripts))
+		{
+			printf("%s: cannot be read\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (scripts.empty())
+	{
+		printf("Usage: TextArtBatch [-j threads] joblist...\n");
+		printf("       TextArtBatch [-j threads] -s script...\n");
+		return 1;
+	}
+
+	// Threads which run out of scripts take over part of another thread's share
+	atomic<int> failed(0);
+	mutex output;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	threads = max(1, min(threads, (int)scripts.size()));
+	runParallel(scripts.size(), threads, [&](size_t job)
+	{
+		string error;
+		if (!runScript(scripts[job].c_str(), error))
+		{
+			failed++;
+			lock_guard<mutex> lock(output);
+			printf("%s: %s\n", scripts[job].c_str(), error.c_str());
+		}
+	});
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	printf("%d of %d scripts ran on %d threads in %.3f s (%.0f scripts/s)\n",
+		(int)scripts.size() - failed, (int)scripts.size(), threads, seconds, scripts.size() / max(seconds, 1e-9));
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,1133 @@
+/*
+* Benchmarks comparing the dense Canvas with the sparse TiledCanvas.
+* Every TXT file in the given directory is loaded into the top left corner
+* of a large canvas, and then each canvas operation is timed on both backends.
+* The screen output for one editor frame is also measured, against the
+* output the original per-character displayCanvas and clearLine produced.
+* Clip sets (files named name-1.txt, name-2.txt, ...) are loaded with
+* loadCanvas and with the original character-at-a-time loader, and
+* loaded again after conversion into one binary clip file.
+* The drawing routines run on each art with animation turned off, with
+* the scanline fill against the recursive one, lines against floating
+* point ones with a bounds check per cell, and
+* rectangles of it are copied, pasted and stamped. Art is also rotated,
+* mirrored and transposed, and rotated without cache blocking to compare.
+* Canvas hashing and the hash-first comparison undo uses are timed too,
+* as is converting a video frame sized image to each canvas size, and
+* drawing a deep tree on 1 to 32 threads. A display list is drawn in full
+* and again in just the rectangle one of its primitives moved out of.
+* Clip sets also time the diffs between consecutive clips, and a stack
+* of layers is composited in full and after changing one layer. The cost
+* of the scoped timer around each editor operation is measured as well.
+*
+* Without a size, every canvas size in SIZES is measured. With --json the
+* results are printed as one JSON object, so runs can be compared over time.
+*
+* Usage: TextArtBench [--json] [directory] [rows cols]
+*/
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include "Definitions.h"
+using namespace std;
+
+// Number of times each operation is repeated; the average time is reported
+const int REPEATS = 50;
+
+// Canvas sizes measured when no size is given
+const int SIZES[][2] = { { 22, 80 }, { 100, 400 }, { 500, 2000 } };
+
+// fillRecursive goes one call deeper per cell, so it is only
+// measured on canvases small enough for the stack; fillScanline
+// is measured at every size
+const int FILLLIMIT = 40000;
+
+// Height of the tree drawn on 1 to 32 threads, about half a million
+// branches, and how often it is drawn; one tree takes tens of milliseconds
+const int TREEHEIGHT = 40;
+const int TREEREPEATS = 5;
+
+// Number of lines, boxes, trees and texts in the timed display list
+const int LISTPRIMITIVES = 200;
+
+// true: results are printed as JSON / false: as a table
+static bool jsonOutput = false;
+
+// Size of the canvases being measured, reported with each result
+static int benchRows = 0;
+static int benchCols = 0;
+
+// Number of JSON results printed so far
+static int jsonResults = 0;
+
+
+// Returns the number of microseconds since the first call
+static double now()
+{
+	static const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+
+// Returns text as a JSON string
+static string jsonString(const string& text)
+{
+	string out = "\"";
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		unsigned char ch = (unsigned char)text[i];
+		if (ch == '"' || ch == '\\')
+		{
+			out += '\\';
+			out += (char)ch;
+		}
+		else if (ch < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+			out += escaped;
+		}
+		else
+		{
+			out += (char)ch;
+		}
+	}
+	return out + "\"";
+}
+
+
+// Starts one JSON result with the fields every result has
+static void beginJsonResult(const string& art, const char* backend, const char* operation)
+{
+	printf("%s\n    {\"input\": %s, \"rows\": %d, \"cols\": %d, \"backend\": %s, \"operation\": %s",
+		jsonResults++ > 0 ? "," : "", jsonString(art).c_str(), benchRows, benchCols,
+		jsonString(backend).c_str(), jsonString(operation).c_str());
+}
+
+
+// Prints one result line
+static void report(const string& art, const char* backend, const char* operation, double micros, size_t bytes)
+{
+	if (jsonOutput)
+	{
+		beginJsonResult(art, backend, operation);
+		printf(", \"micros\": %.3f, \"bytes\": %zu}", micros, bytes);
+		return;
+	}
+	printf("%-16s %-7s %-10s %12.2f us %12zu bytes\n", art.c_str(), backend, operation, micros, bytes);
+}
+
+
+// Draws every non-space cell of art into canvas through drawHelper
+template <typename C>
+static void drawArt(C& canvas, const Canvas& art)
+{
+	for (int row = 0; row < art.rows(); row++)
+	{
+		for (int col = 0; col < art.cols(); col++)
+		{
+			if (art[row][col] != ' ')
+				drawHelper(canvas, Point(row, col), art[row][col], false);
+		}
+	}
+}
+
+
+// Times every operation on one backend; C is Canvas or TiledCanvas
+template <typename C>
+static void runBackend(const string& name, const char* backend, const Canvas& art, int rows, int cols, size_t (*bytes)(const C&))
+{
+	C canvas, copy;
+	double start;
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		copyCanvas(canvas, art);
+	}
+	report(name, backend, "convert", (now() - start) / REPEATS, bytes(canvas));
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		copyCanvas(copy, canvas);
+	}
+	report(name, backend, "copy", (now() - start) / REPEATS, bytes(copy));
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		replace(copy, '#', '*');
+		replace(copy, '*', '#');
+	}
+	report(name, backend, "replace", (now() - start) / (2 * REPEATS), bytes(copy));
+
+	// Remapping a palette of six characters: six chained replaces
+	// against one translate pass
+	const char palette[] = "#*.-|/";
+	const char remapped[] = "@+:=!\\";
+	const int paletteSize = 6;
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		for (int k = 0; k < paletteSize; k++)
+			replace(copy, palette[k], remapped[k]);
+		for (int k = 0; k < paletteSize; k++)
+			replace(copy, remapped[k], palette[k]);
+	}
+	report(name, backend, "replace6", (now() - start) / (2 * REPEATS), bytes(copy));
+
+	char forward[CHARSETSIZE], backward[CHARSETSIZE];
+	initTranslation(forward);
+	initTranslation(backward);
+	for (int k = 0; k < paletteSize; k++)
+	{
+		forward[(unsigned char)palette[k]] = remapped[k];
+		backward[(unsigned char)remapped[k]] = palette[k];
+	}
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		translate(copy, forward);
+		translate(copy, backward);
+	}
+	report(name, backend, "translate6", (now() - start) / (2 * REPEATS), bytes(copy));
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		moveCanvas(copy, 3, 5);
+		moveCanvas(copy, -3, -5);
+	}
+	report(name, backend, "move", (now() - start) / (2 * REPEATS), bytes(copy));
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		initCanvas(copy);
+	}
+	report(name, backend, "init", (now() - start) / REPEATS, bytes(copy));
+
+	C drawn;
+	copyCanvas(drawn, Canvas(rows, cols));
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		drawArt(drawn, art);
+	}
+	report(name, backend, "draw", (now() - start) / REPEATS, bytes(drawn));
+
+	// Only ever "bench-" and a backend name, so the path always fits
+	char saveName[32];
+	snprintf(saveName, sizeof(saveName), "bench-%s", backend);
+	char savePath[FILENAMESIZE];
+	snprintf(savePath, FILENAMESIZE, "SavedFiles/%s.txt", saveName);
+
+	// Reported with the size of the file written
+	for (int fixedWidth = 0; fixedWidth <= 1; fixedWidth++)
+	{
+		start = now();
+		bool saved = saveCanvas(canvas, saveName, fixedWidth == 1);
+		double micros = now() - start;
+
+		const char* operation = fixedWidth ? "save-fixed" : "save";
+		report(name, backend, saved ? operation : "save-fail", micros, saved ? (size_t)filesystem::file_size(savePath) : 0);
+		remove(savePath);
+	}
+}
+
+
+// Counts bytes and write calls. The original displayCanvas and clearLine wrote
+// to an unbuffered console, so each stream insertion was one write.
+class CountingBuffer : public streambuf
+{
+public:
+	long long bytes = 0;
+	long long writes = 0;
+
+protected:
+	int overflow(int ch) override { bytes++; writes++; return ch; }
+	streamsize xsputn(const char*, streamsize n) override { bytes += n; writes++; return n; }
+};
+
+
+// Output of one main menu frame as the original code produced it:
+// four clearLine calls, displayCanvas and the menu line
+static FrameStats legacyFrame(const Canvas& canvas, const char* menu)
+{
+	CountingBuffer counter;
+	ostream out(&counter);
+	int width = canvas.cols() + BUFFERSIZE;
+
+	for (int line = 0; line < 4; line++)
+	{
+		counter.writes += 2;	// gotoxy before and after
+		for (int x = 0; x < width; x++)
+			out << " ";
+	}
+
+	counter.writes++;	// gotoxy(0, 0)
+	for (int row = 0; row < canvas.rows(); row++)
+	{
+		for (int col = 0; col < canvas.cols(); col++)
+			out << canvas[row][col];
+		out << "|" << endl;
+	}
+	for (int col = 0; col < canvas.cols(); col++)
+		out << "-";
+	out << endl;
+	out << menu;
+
+	FrameStats stats;
+	stats.bytes = counter.bytes;
+	stats.writes = counter.writes;
+	stats.frames = 1;
+	return stats;
+}
+
+
+// Output of one main menu frame as the editor now builds it
+static FrameStats currentFrame(const Canvas& canvas, const char* menu)
+{
+	resetFrameStats();
+	beginFrame();
+	for (int line = canvas.rows() + 1; line <= canvas.rows() + 4; line++)
+	{
+		clearLine(line);
+	}
+	displayCanvas(canvas);
+	framePrintf("%s", menu);
+	endFrame();
+	return frameStats();
+}
+
+
+static void reportFrame(const string& art, const char* method, const char* frame, const FrameStats& stats)
+{
+	if (jsonOutput)
+	{
+		beginJsonResult(art, method, frame);
+		printf(", \"bytes\": %lld, \"writes\": %lld}", stats.bytes, stats.writes);
+		return;
+	}
+	printf("%-16s %-7s %-10s %12lld bytes %6lld writes\n", art.c_str(), method, frame, stats.bytes, stats.writes);
+}
+
+
+// Measures the screen output of a full frame and of a frame after a small edit
+static void runFrames(const string& name, const char* filename)
+{
+	const char menu[] = "<E>dit / <M>ove / <R>eplace / <D>raw / <C>lear / <U>ndo / <L>oad / <S>ave / <Q>uit: ";
+	char path[FILENAMESIZE];
+	snprintf(path, FILENAMESIZE, "%s", filename);
+
+	Canvas canvas(MAXROWS, MAXCOLS);
+	if (!loadCanvas(canvas, path))
+		return;
+
+	reportFrame(name, "legacy", "frame", legacyFrame(canvas, menu));
+
+	setFrameOutput(false);
+	invalidateDisplay();
+	reportFrame(name, "batched", "full", currentFrame(canvas, menu));
+
+	canvas[MAXROWS / 2][MAXCOLS / 2] = canvas[MAXROWS / 2][MAXCOLS / 2] == '#' ? '*' : '#';
+	reportFrame(name, "batched", "one-cell", currentFrame(canvas, menu));
+	setFrameOutput(true);
+}
+
+
+// Times the wrap-around move, which only the dense Canvas has
+static void runWrap(const string& name, const Canvas& art)
+{
+	Canvas canvas;
+	copyCanvas(canvas, art);
+
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		moveCanvas(canvas, 3, 5, true);
+		moveCanvas(canvas, -3, -5, true);
+	}
+	report(name, "dense", "wrap", (now() - start) / (2 * REPEATS), canvas.size());
+}
+
+
+// Times hashing a canvas, and the undo check which compares it with a
+// changed copy and with an identical one
+static void runHash(const string& name, const Canvas& art)
+{
+	Canvas changed;
+	copyCanvas(changed, art);
+	changed[art.rows() - 1][art.cols() - 1] ^= 1;
+	uint64_t artHash = hashCanvas(art);
+	uint64_t changedHash = hashCanvas(changed);
+	uint64_t sum = 0;
+
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		sum += hashCanvas(art);
+	}
+	report(name, "dense", "hash", (now() - start) / REPEATS, art.size());
+
+	int same = 0;
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		same += sameCanvas(art, artHash, changed, changedHash);
+	}
+	report(name, "dense", "differ", (now() - start) / REPEATS, art.size());
+
+	Canvas copy;
+	copyCanvas(copy, art);
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		same += sameCanvas(art, artHash, copy, artHash);
+	}
+	report(name, "dense", "equal", (now() - start) / REPEATS, art.size());
+
+	// Keeps the loops from being optimized away
+	if (sum == 0 && same < 0)
+		printf("\n");
+}
+
+
+// Times converting a synthetic 1920 x 1080 video frame to a canvas of the
+// current size, on one thread and on every core
+static void runImage()
+{
+	Image image;
+	image.width = 1920;
+	image.height = 1080;
+	image.pixels.resize((size_t)image.width * image.height);
+	for (int y = 0; y < image.height; y++)
+	{
+		for (int x = 0; x < image.width; x++)
+			image.pixels[(size_t)y * image.width + x] = (unsigned char)((x * 255 / image.width + y * 7) & 0xFF);
+	}
+
+	Canvas canvas(benchRows, benchCols);
+	const int threadCounts[] = { 1, 0 };
+	const char* backends[] = { "single", "threads" };
+	for (int t = 0; t < 2; t++)
+	{
+		double start = now();
+		for (int i = 0; i < REPEATS; i++)
+		{
+			imageToCanvas(canvas, image, DEFAULTRAMP, threadCounts[t]);
+		}
+		report("frame1080", backends[t], "image", (now() - start) / REPEATS, image.pixels.size());
+	}
+}
+
+
+// Times a deep tree growing up from the bottom middle of a blank canvas of
+// the current size, drawn by treeRecursive and by treeParallel on 1 to 32
+// threads, and checks that every thread count draws the same tree
+static void runTreeThreads()
+{
+	Canvas expected(benchRows, benchCols);
+	Canvas canvas(benchRows, benchCols);
+	DrawPoint base(benchRows - 1, benchCols / 2);
+
+	double start = now();
+	for (int i = 0; i < TREEREPEATS; i++)
+	{
+		initCanvas(expected);
+		treeRecursive(expected, base, TREEHEIGHT, 270, 25, false);
+	}
+	report("tree40", "single", "tree", (now() - start) / TREEREPEATS, expected.size());
+
+	const int threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+	for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++)
+	{
+		start = now();
+		for (int i = 0; i < TREEREPEATS; i++)
+		{
+			initCanvas(canvas);
+			treeParallel(canvas, base, TREEHEIGHT, 270, 25, threadCounts[t]);
+		}
+		char operation[16];
+		snprintf(operation, sizeof(operation), "tree-%dt", threadCounts[t]);
+		report("tree40", "threads", operation, (now() - start) / TREEREPEATS, canvas.size());
+
+		for (int row = 0; row < canvas.rows(); row++)
+		{
+			if (memcmp(canvas[row], expected[row], canvas.cols()) != 0)
+			{
+				fprintf(stderr, "tree40: %d threads drew a different tree\n", threadCounts[t]);
+				break;
+			}
+		}
+	}
+}
+
+
+// Times drawing a display list of LISTPRIMITIVES primitives spread over a
+// canvas of the current size, then moving one box and drawing again only
+// the rectangles it left and went to, which must match drawing it all again
+static void runDisplayList()
+{
+	DisplayList list(benchRows, benchCols);
+	for (int i = 0; i < LISTPRIMITIVES; i++)
+	{
+		DrawPrimitive primitive;
+		primitive.kind = (PrimitiveKind)(i % 4 == 3 ? PRIMITIVETEXT : i % 4);
+		primitive.a = Point(i * 7 % benchRows, i * 13 % benchCols);
+		primitive.b = Point((i * 11 + 5) % benchRows, (i * 17 + 9) % benchCols);
+		primitive.size = 4 + i % 6;
+		primitive.angle = 20 + i % 20;
+		primitive.text = "display list";
+		list.add(primitive);
+	}
+
+	Canvas canvas(benchRows, benchCols);
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		initCanvas(canvas);
+		list.rasterize(canvas);
+	}
+	report("list200", "dense", "rasterize", (now() - start) / REPEATS, canvas.size());
+
+	// Move box 1 back and forth, so every repeat changes the canvas
+	const int moved = 1;
+	DrawPrimitive box = list[moved];
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		int top, left, bottom, right;
+		bool wasDrawn = list.bounds(moved, canvas, top, left, bottom, right);
+		box.a.col += i % 2 == 0 ? 3 : -3;
+		list.replace(moved, box);
+		if (wasDrawn)
+			list.rasterizeRegion(canvas, Point(top, left), Point(bottom, right));
+		if (list.bounds(moved, canvas, top, left, bottom, right))
+			list.rasterizeRegion(canvas, Point(top, left), Point(bottom, right));
+	}
+	report("list200", "dense", "region", (now() - start) / REPEATS, canvas.size());
+
+	Canvas expected(benchRows, benchCols);
+	list.rasterize(expected);
+	for (int row = 0; row < canvas.rows(); row++)
+	{
+		if (memcmp(canvas[row], expected[row], canvas.cols()) != 0)
+		{
+			fprintf(stderr, "list200: drawing a region differs from drawing the list\n");
+			break;
+		}
+	}
+}
+
+
+// Times compositing a document of LAYERCOUNT layers, each holding a box at
+// its own place: all rows, then after drawing into one layer, then after
+// hiding or showing one layer
+static void runLayers()
+{
+	const int LAYERCOUNT = 10;
+	LayerStack layers(benchRows, benchCols);
+	for (int i = 0; i < LAYERCOUNT; i++)
+	{
+		int index = layers.addLayer("layer" + to_string(i), ' ');
+		Point center(benchRows * (i + 1) / (LAYERCOUNT + 1), benchCols * (i + 1) / (LAYERCOUNT + 1));
+		drawBox(layers.beginEdit(index), center, max(2, benchRows / 8), false);
+		layers.endEdit(index);
+	}
+
+	Canvas canvas;
+	int rows = 0;
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		layers.invalidate();
+		rows += layers.composite(canvas);
+	}
+	report("layers", "dense", "composite", (now() - start) / REPEATS, (size_t)rows / REPEATS * canvas.stride());
+
+	rows = 0;
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		// Draw the line, then rub it out again, so every edit changes one row
+		Canvas& layer = layers.beginEdit(LAYERCOUNT / 2);
+		if (i % 2 == 0)
+			drawLine(layer, DrawPoint(benchRows / 2, 0), DrawPoint(benchRows / 2, benchCols / 4), false);
+		else
+			memset(layer[benchRows / 2], ' ', benchCols / 4 + 1);
+		layers.endEdit(LAYERCOUNT / 2);
+		rows += layers.composite(canvas);
+	}
+	report("layers", "dense", "edit", (now() - start) / REPEATS, (size_t)rows / REPEATS * canvas.stride());
+
+	rows = 0;
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		layers.setVisible(0, i % 2 != 0);
+		rows += layers.composite(canvas);
+	}
+	report("layers", "dense", "toggle", (now() - start) / REPEATS, (size_t)rows / REPEATS * canvas.stride());
+}
+
+
+// Rotates a canvas a quarter turn clockwise one cell at a time, down the
+// columns of the source, the way it would be written without blocking
+static void naiveRotate(Canvas& to, const Canvas& from)
+{
+	to.resize(from.cols(), from.rows());
+	for (int row = 0; row < to.rows(); row++)
+	{
+		for (int col = 0; col < to.cols(); col++)
+			to[row][col] = from[from.rows() - 1 - col][row];
+	}
+}
+
+
+// Times each transform on a copy of art, against a rotation without blocking
+static void runTransforms(const string& name, const Canvas& art)
+{
+	const struct { CanvasTransform transform; const char* operation; } transforms[] =
+	{
+		{ MIRRORLEFTRIGHT, "mirror-lr" }, { MIRRORTOPBOTTOM, "mirror-tb" }, { ROTATE180, "rotate180" },
+		{ ROTATE90, "rotate90" }, { TRANSPOSE, "transpose" },
+	};
+
+	Canvas canvas;
+	copyCanvas(canvas, art);
+	for (size_t t = 0; t < sizeof(transforms) / sizeof(transforms[0]); t++)
+	{
+		double start = now();
+		for (int i = 0; i < REPEATS; i++)
+		{
+			transformCanvas(canvas, transforms[t].transform, true);
+		}
+		report(name, "dense", transforms[t].operation, (now() - start) / REPEATS, canvas.size());
+	}
+
+	Canvas turned;
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		naiveRotate(turned, art);
+	}
+	report(name, "legacy", "rotate90", (now() - start) / REPEATS, turned.size());
+}
+
+
+// Times one scoped timer, which every editor operation pays for
+static void runTimer()
+{
+	const int TIMINGS = REPEATS * 1000;
+	double start = now();
+	for (int i = 0; i < TIMINGS; i++)
+	{
+		ScopedTimer timer(TIMEDISPLAY);
+	}
+	report("latency", "dense", "timer", (now() - start) / TIMINGS, 0);
+	resetLatencies();
+}
+
+
+// Draws a line the way drawLine did before it used whole numbers: the row at
+// each column from floating point, and a bounds check for every cell
+static void naiveLine(Canvas& canvas, DrawPoint start, DrawPoint end)
+{
+	Point scrStart(start);
+	Point scrEnd(end);
+	int dir = scrEnd.col >= scrStart.col ? 1 : -1;
+	double slope = scrStart.col == scrEnd.col ? 0 : (start.row - end.row) / (start.col - end.col);
+	int prevRow = scrStart.row;
+	for (int col = scrStart.col; col != scrEnd.col + dir; col += dir)
+	{
+		int row = scrStart.col == scrEnd.col ? scrEnd.row : (int)round(slope * (col - start.col) + start.row);
+		for (int r = min(prevRow, row); r <= max(prevRow, row); r++)
+		{
+			if (canvas.contains(r, col))
+				canvas[r][col] = '*';
+		}
+		prevRow = row;
+	}
+}
+
+
+// Draws both diagonals, the middle row and the middle column, stretched
+// reach times past the canvas on both ends, with drawLine or naiveLine
+static void drawLines(Canvas& canvas, int reach, bool naive)
+{
+	int rows = canvas.rows();
+	int cols = canvas.cols();
+	DrawPoint lines[4][2] =
+	{
+		{ DrawPoint(-reach * rows, -reach * cols), DrawPoint(rows - 1 + reach * rows, cols - 1 + reach * cols) },
+		{ DrawPoint(rows - 1 + reach * rows, -reach * cols), DrawPoint(-reach * rows, cols - 1 + reach * cols) },
+		{ DrawPoint(rows / 2, -reach * cols), DrawPoint(rows / 2, cols - 1 + reach * cols) },
+		{ DrawPoint(-reach * rows, cols / 2), DrawPoint(rows - 1 + reach * rows, cols / 2) },
+	};
+	for (int l = 0; l < 4; l++)
+	{
+		if (naive)
+			naiveLine(canvas, lines[l][0], lines[l][1]);
+		else
+			drawLine(canvas, lines[l][0], lines[l][1], false);
+	}
+}
+
+
+// Times the drawing routines, with animation off, on copies of art.
+// Each repeat starts from a fresh copy, which is not counted.
+static void runDrawing(const string& name, const Canvas& art, const char* filename)
+{
+	int rows = art.rows();
+	int cols = art.cols();
+	Canvas canvas;
+	double start, total;
+	char path[FILENAMESIZE];
+	snprintf(path, FILENAMESIZE, "%s", filename);
+
+	copyCanvas(canvas, art);
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		loadCanvas(canvas, path);
+	}
+	report(name, "dense", "load", (now() - start) / REPEATS, canvas.size());
+
+	// Lines across the canvas, then lines reaching far past its edges
+	const struct { int reach; const char* operation; } lines[] = { { 0, "line" }, { 4, "line-clip" } };
+	for (size_t l = 0; l < sizeof(lines) / sizeof(lines[0]); l++)
+	{
+		for (int naive = 0; naive < 2; naive++)
+		{
+			total = 0;
+			for (int i = 0; i < REPEATS; i++)
+			{
+				copyCanvas(canvas, art);
+				start = now();
+				drawLines(canvas, lines[l].reach, naive != 0);
+				total += now() - start;
+			}
+			report(name, naive ? "legacy" : "dense", lines[l].operation, total / REPEATS, canvas.size());
+		}
+	}
+
+	Point center(rows / 2, cols / 2);
+	total = 0;
+	for (int i = 0; i < REPEATS; i++)
+	{
+		copyCanvas(canvas, art);
+		start = now();
+		drawBox(canvas, center, rows / 2, false);
+		total += now() - start;
+	}
+	report(name, "dense", "box", total / REPEATS, canvas.size());
+
+	total = 0;
+	for (int i = 0; i < REPEATS; i++)
+	{
+		copyCanvas(canvas, art);
+		start = now();
+		drawBoxesRecursive(canvas, center, rows - 2, false);
+		total += now() - start;
+	}
+	report(name, "dense", "boxes", total / REPEATS, canvas.size());
+
+	// The number of branches doubles every two rows of height; the deep
+	// tree has half a million, most of them off smaller canvases
+	const struct { int height; const char* operation; } trees[] = { { min(rows - 1, 24), "tree" }, { 40, "tree-deep" } };
+	for (size_t t = 0; t < sizeof(trees) / sizeof(trees[0]); t++)
+	{
+		total = 0;
+		for (int i = 0; i < REPEATS; i++)
+		{
+			copyCanvas(canvas, art);
+			start = now();
+			treeRecursive(canvas, DrawPoint(rows - 1, cols / 2), trees[t].height, 270, 25, false);
+			total += now() - start;
+		}
+		report(name, "dense", trees[t].operation, total / REPEATS, canvas.size());
+	}
+
+	// Copy the middle of the art, then paste it over the top left corner
+	// with and without transparent spaces
+	Canvas clipboard;
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		copyRegion(clipboard, art, Point(rows / 4, cols / 4), Point(rows * 3 / 4, cols * 3 / 4));
+	}
+	report(name, "dense", "copy-rect", (now() - start) / REPEATS, clipboard.size());
+
+	copyCanvas(canvas, art);
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		pasteCanvas(canvas, clipboard, Point(1, 1), false);
+	}
+	report(name, "dense", "paste", (now() - start) / REPEATS, clipboard.size());
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		pasteCanvas(canvas, clipboard, Point(1, 1), true);
+	}
+	report(name, "dense", "paste-opq", (now() - start) / REPEATS, clipboard.size());
+
+	// Stamping includes reading the file, like loading does
+	copyCanvas(canvas, art);
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		stampCanvas(canvas, path, center);
+	}
+	report(name, "dense", "stamp", (now() - start) / REPEATS, canvas.size());
+
+	// Fill the area around the bottom right corner, and a blank canvas
+	// of the same size, where every cell is in one area
+	Canvas blank(rows, cols);
+	const struct { const Canvas* canvas; const char* area; } areas[] = { { &art, "" }, { &blank, "blank" } };
+	for (int a = 0; a < 2; a++)
+	{
+		const Canvas& area = *areas[a].canvas;
+		char oldCh = area[rows - 1][cols - 1];
+		char newCh = oldCh == '.' ? ',' : '.';
+		const struct { bool diagonal; const char* operation; } fills[] = { { false, "fill" }, { true, "fill8" } };
+		for (int f = 0; f < 2; f++)
+		{
+			string operation = string(fills[f].operation) + areas[a].area;
+			total = 0;
+			for (int i = 0; i < REPEATS; i++)
+			{
+				copyCanvas(canvas, area);
+				start = now();
+				fillScanline(canvas, rows - 1, cols - 1, newCh, fills[f].diagonal, false);
+				total += now() - start;
+			}
+			report(name, "dense", operation.c_str(), total / REPEATS, canvas.size());
+		}
+
+		if ((long long)rows * cols <= FILLLIMIT)
+		{
+			total = 0;
+			for (int i = 0; i < REPEATS; i++)
+			{
+				copyCanvas(canvas, area);
+				start = now();
+				fillRecursive(canvas, rows - 1, cols - 1, oldCh, newCh, false);
+				total += now() - start;
+			}
+			report(name, "legacy", (string("fill") + areas[a].area).c_str(), total / REPEATS, canvas.size());
+		}
+	}
+}
+
+
+// The original loadCanvas, which read one character at a time
+static bool legacyLoad(Canvas& canvas, const char* filename)
+{
+	ifstream inFile;
+	inFile.open(filename);
+	if (!inFile)
+		return false;
+
+	initCanvas(canvas);
+
+	int c = inFile.get();
+	for (int row = 0; row <= canvas.rows() + BUFFERSIZE && !inFile.eof();)
+	{
+		for (int col = 0; col <= canvas.cols() + BUFFERSIZE && !inFile.eof(); col++)
+		{
+			if (cin.fail())
+			{
+				cin.clear();
+				cin.ignore(numeric_limits<streamsize>::max(), '\n');
+			}
+			else if (row < canvas.rows() && col < canvas.cols())
+			{
+				if (c == '\n')
+				{
+					row++;
+					col = -1;
+				}
+				else
+				{
+					canvas[row][col] = c;
+				}
+				c = inFile.get();
+			}
+			else
+			{
+				while (c != '\n' && c != EOF)
+				{
+					c = inFile.get();
+				}
+				row++;
+				col = -1;
+				c = inFile.get();
+			}
+		}
+	}
+	inFile.close();
+	return true;
+}
+
+
+// Times finding, applying and inverting the changes between consecutive
+// clips of a clip set. The size is what the runs and their cells take,
+// against the cells of the whole frames.
+static void runDiff(const string& name, vector<string> clips)
+{
+	// In the order the clips play, which is not the order of their names
+	sort(clips.begin(), clips.end(), [](const string& a, const string& b)
+		{
+			return atoi(a.c_str() + a.rfind('-') + 1) < atoi(b.c_str() + b.rfind('-') + 1);
+		});
+
+	char path[FILENAMESIZE];
+	vector<Canvas> frames(clips.size(), Canvas(MAXROWS, MAXCOLS));
+	for (size_t k = 0; k < clips.size(); k++)
+	{
+		snprintf(path, FILENAMESIZE, "%s", clips[k].c_str());
+		loadCanvas(frames[k], path);
+	}
+	if (frames.size() < 2)
+		return;
+
+	int pairs = (int)frames.size() - 1;
+	vector<CanvasDiff> diffs(pairs);
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		for (int k = 0; k < pairs; k++)
+			diffCanvas(frames[k], frames[k + 1], diffs[k]);
+	}
+	double micros = (now() - start) / (REPEATS * pairs);
+
+	size_t bytes = 0;
+	for (int k = 0; k < pairs; k++)
+		bytes += diffs[k].runs.size() * DIFFRUNHEADERSIZE + diffs[k].after.size();
+	report(name, "dense", "diff", micros, bytes / pairs);
+
+	// Plays the clips forward, then back to the first one
+	Canvas canvas;
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		copyCanvas(canvas, frames[0]);
+		for (int k = 0; k < pairs; k++)
+			applyDiff(canvas, diffs[k]);
+	}
+	report(name, "dense", "patch", (now() - start) / (REPEATS * pairs), bytes / pairs);
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		for (int k = pairs - 1; k >= 0; k--)
+		{
+			invertDiff(diffs[k]);
+			applyDiff(canvas, diffs[k]);
+			invertDiff(diffs[k]);
+		}
+		for (int k = 0; k < pairs; k++)
+			applyDiff(canvas, diffs[k]);
+	}
+	report(name, "dense", "unpatch", (now() - start) / (REPEATS * pairs * 2), bytes / pairs);
+
+	if (memcmp(canvas.data(), frames[pairs].data(), canvas.size()) != 0)
+		fprintf(stderr, "%s: patches do not reproduce the clips\n", name.c_str());
+	if (!jsonOutput)
+	{
+		printf("%-16s %-7s %-10s %12.1fx smaller than whole frames\n", name.c_str(), "dense", "diff",
+			(double)pairs * MAXROWS * MAXCOLS / max(bytes, (size_t)1));
+	}
+}
+
+
+// Times loading every clip of a set, with the original loader and with loadCanvas
+static void runLoad(const string& name, const vector<string>& clips)
+{
+	Canvas canvas(MAXROWS, MAXCOLS);
+	char path[FILENAMESIZE];
+	size_t bytes = 0;
+	for (size_t i = 0; i < clips.size(); i++)
+		bytes += filesystem::file_size(clips[i]);
+
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		for (size_t k = 0; k < clips.size(); k++)
+			legacyLoad(canvas, clips[k].c_str());
+	}
+	double legacy = (now() - start) / REPEATS;
+	report(name, "legacy", "load", legacy, bytes);
+
+	LoadStats stats, total;
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		total = LoadStats();
+		for (size_t k = 0; k < clips.size(); k++)
+		{
+			snprintf(path, FILENAMESIZE, "%s", clips[k].c_str());
+			loadCanvas(canvas, path, stats);
+			total.truncatedLines += stats.truncatedLines;
+			total.droppedLines += stats.droppedLines;
+		}
+	}
+	double bulk = (now() - start) / REPEATS;
+	report(name, "bulk", "load", bulk, bytes);
+
+	if (!jsonOutput)
+	{
+		printf("%-16s %-7s %-10s %12.1fx %6d cut %6d dropped\n", name.c_str(), "bulk", "speedup",
+			legacy / bulk, total.truncatedLines, total.droppedLines);
+	}
+
+	// The same clips as one binary clip file, written next to the text files
+	vector<Canvas> frames(clips.size(), Canvas(MAXROWS, MAXCOLS));
+	vector<const Canvas*> framePointers;
+	for (size_t k = 0; k < clips.size(); k++)
+	{
+		snprintf(path, FILENAMESIZE, "%s", clips[k].c_str());
+		loadCanvas(frames[k], path);
+		framePointers.push_back(&frames[k]);
+	}
+
+	string binary = (filesystem::path(clips[0]).parent_path() / ("bench-" + name.substr(0, name.size() - 2) + BINARYEXTENSION)).string();
+	if (!writeFramesFile(framePointers.data(), (int)framePointers.size(), binary.c_str()))
+		return;
+	size_t binaryBytes = filesystem::file_size(binary);
+	snprintf(path, FILENAMESIZE, "%s", binary.c_str());
+
+	start = now();
+	for (int i = 0; i < REPEATS; i++)
+	{
+		loadFrames(frames, path);
+	}
+	double binaryLoad = (now() - start) / REPEATS;
+	report(name, "binary", "load", binaryLoad, binaryBytes);
+	if (!jsonOutput)
+	{
+		printf("%-16s %-7s %-10s %12.1fx %12.1fx smaller\n", name.c_str(), "binary", "speedup",
+			legacy / binaryLoad, (double)bytes / binaryBytes);
+	}
+
+	remove(binary.c_str());
+}
+
+
+static size_t denseBytes(const Canvas& canvas) { return canvas.size(); }
+static size_t sparseBytes(const TiledCanvas& canvas) { return canvas.memoryUsed(); }
+
+
+int main(int argc, char* argv[])
+{
+	vector<string> args;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--json") == 0)
+			jsonOutput = true;
+		else
+			args.push_back(argv[i]);
+	}
+
+	string directory = args.size() >= 1 ? args[0] : "SavedFiles";
+	vector<pair<int, int>> sizes;
+	if (args.size() >= 3 && atoi(args[1].c_str()) > 0 && atoi(args[2].c_str()) > 0)
+	{
+		sizes.push_back(make_pair(atoi(args[1].c_str()), atoi(args[2].c_str())));
+	}
+	else
+	{
+		for (size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); i++)
+			sizes.push_back(make_pair(SIZES[i][0], SIZES[i][1]));
+	}
+
+	vector<string> files;
+	for (const filesystem::directory_entry& entry : filesystem::directory_iterator(directory))
+	{
+		if (entry.path().extension() == ".txt")
+			files.push_back(entry.path().string());
+	}
+	sort(files.begin(), files.end());
+
+	if (jsonOutput)
+		printf("{\"repeats\": %d, \"results\": [", REPEATS);
+
+	// Clip loading and screen frames are measured at the editor's size
+	benchRows = MAXROWS;
+	benchCols = MAXCOLS;
+	if (!jsonOutput)
+		printf("Canvas size: %d x %d, %d repeats\n", benchRows, benchCols, REPEATS);
+
+	runTimer();
+
+	// Group clip files by the name before the clip number
+	map<string, vector<string>> clipSets;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		string stem = filesystem::path(files[i]).stem().string();
+		size_t dash = stem.rfind('-');
+		if (dash != string::npos && dash + 1 < stem.size() && isdigit((unsigned char)stem[dash + 1]))
+			clipSets[stem.substr(0, dash)].push_back(files[i]);
+	}
+	for (map<string, vector<string>>::const_iterator set = clipSets.begin(); set != clipSets.end(); ++set)
+	{
+		runLoad(set->first + "-*", set->second);
+		runDiff(set->first + "-*", set->second);
+	}
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		runFrames(filesystem::path(files[i]).stem().string(), files[i].c_str());
+	}
+
+	for (size_t s = 0; s < sizes.size(); s++)
+	{
+		benchRows = sizes[s].first;
+		benchCols = sizes[s].second;
+		if (!jsonOutput)
+			printf("Canvas size: %d x %d, %d repeats\n", benchRows, benchCols, REPEATS);
+
+		runImage();
+		runTreeThreads();
+		runDisplayList();
+		runLayers();
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			char path[FILENAMESIZE];
+			snprintf(path, FILENAMESIZE, "%s", files[i].c_str());
+
+			Canvas art(benchRows, benchCols);
+			if (!loadCanvas(art, path))
+			{
+				fprintf(stderr, "%s: cannot be read\n", path);
+				continue;
+			}
+
+			string name = filesystem::path(files[i]).stem().string();
+			runBackend<Canvas>(name, "dense", art, benchRows, benchCols, denseBytes);
+			runBackend<TiledCanvas>(name, "sparse", art, benchRows, benchCols, sparseBytes);
+			runWrap(name, art);
+			runHash(name, art);
+			runDrawing(name, art, files[i].c_str());
+			runTransforms(name, art);
+		}
+	}
+
+	if (jsonOutput)
+		printf("\n]}\n");
+	return 0;
+}
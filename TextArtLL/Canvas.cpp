@@ -0,0 +1,1335 @@
+#define NOMINMAX
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <climits>
+#include <fcntl.h>
+#include "Definitions.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CANVAS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CANVAS_SSE2
+#endif
+
+using namespace std;
+
+
+void Canvas::resize(int rows, int cols)
+{
+	if (rows < 0) rows = 0;
+	if (cols < 0) cols = 0;
+
+	numRows = rows;
+	numCols = cols;
+
+	// round each row up to a multiple of CANVASALIGN bytes
+	rowStride = (cols + CANVASALIGN - 1) / CANVASALIGN * CANVASALIGN;
+
+	cells.assign((size_t)numRows * rowStride, ' ');
+}
+
+
+/**
+* Sets up a translation map which leaves every character unchanged.
+*
+* @param[out] map Map with CHARSETSIZE entries
+*/
+void initTranslation(char map[])
+{
+	for (int ch = 0; ch < CHARSETSIZE; ch++)
+	{
+		map[ch] = (char)ch;
+	}
+}
+
+
+/**
+* Translates count characters in place through a translation map.
+* When the map changes at most MAXSIMDPAIRS characters, every change is
+* checked with vector compares in one pass; otherwise each character is
+* looked up in the map.
+*
+* @param[in] cells Characters to translate
+* @param count Number of characters
+* @param[in] map Translation map with CHARSETSIZE entries
+*/
+void translateCells(char* cells, size_t count, const char map[])
+{
+	unsigned char from[MAXSIMDPAIRS], to[MAXSIMDPAIRS];
+	int pairs = 0;
+
+	for (int ch = 0; ch < CHARSETSIZE && pairs >= 0; ch++)
+	{
+		if (map[ch] != (char)ch)
+		{
+			if (pairs == MAXSIMDPAIRS)
+			{
+				pairs = -1;    // too many changes; use the map directly
+			}
+			else
+			{
+				from[pairs] = (unsigned char)ch;
+				to[pairs] = (unsigned char)map[ch];
+				pairs++;
+			}
+		}
+	}
+
+	if (pairs == 0)
+		return;
+
+	size_t i = 0;
+
+#if defined(CANVAS_AVX2)
+	if (pairs > 0)
+	{
+		__m256i fromV[MAXSIMDPAIRS], toV[MAXSIMDPAIRS];
+		for (int k = 0; k < pairs; k++)
+		{
+			fromV[k] = _mm256_set1_epi8((char)from[k]);
+			toV[k] = _mm256_set1_epi8((char)to[k]);
+		}
+
+		for (; i + 32 <= count; i += 32)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*)(cells + i));
+			__m256i result = v;
+			__m256i any = _mm256_setzero_si256();
+
+			// Compare against the original bytes so the changes do not chain
+			for (int k = 0; k < pairs; k++)
+			{
+				__m256i match = _mm256_cmpeq_epi8(v, fromV[k]);
+				result = _mm256_blendv_epi8(result, toV[k], match);
+				any = _mm256_or_si256(any, match);
+			}
+
+			if (!_mm256_testz_si256(any, any))
+				_mm256_storeu_si256((__m256i*)(cells + i), result);
+		}
+	}
+#elif defined(CANVAS_SSE2)
+	if (pairs > 0)
+	{
+		__m128i fromV[MAXSIMDPAIRS], toV[MAXSIMDPAIRS];
+		for (int k = 0; k < pairs; k++)
+		{
+			fromV[k] = _mm_set1_epi8((char)from[k]);
+			toV[k] = _mm_set1_epi8((char)to[k]);
+		}
+
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(cells + i));
+			__m128i result = v;
+			__m128i any = _mm_setzero_si128();
+
+			// Compare against the original bytes so the changes do not chain
+			for (int k = 0; k < pairs; k++)
+			{
+				__m128i match = _mm_cmpeq_epi8(v, fromV[k]);
+				result = _mm_or_si128(_mm_and_si128(match, toV[k]), _mm_andnot_si128(match, result));
+				any = _mm_or_si128(any, match);
+			}
+
+			if (_mm_movemask_epi8(any) != 0)
+				_mm_storeu_si128((__m128i*)(cells + i), result);
+		}
+	}
+#endif
+
+	// Scalar fallback, and whatever is left after the last full vector
+	for (; i < count; i++)
+	{
+		cells[i] = map[(unsigned char)cells[i]];
+	}
+}
+
+
+/**
+* Translates every cell of the canvas through a translation map in a single pass.
+*
+* @param canvas[in] Canvas to update
+* @param[in] map Translation map with CHARSETSIZE entries
+*/
+void translate(Canvas& canvas, const char map[])
+{
+	// Row padding holds spaces; if spaces stay spaces the whole buffer
+	// can be translated at once, padding included
+	if (map[(unsigned char)' '] == ' ')
+	{
+		translateCells(canvas.data(), canvas.size(), map);
+		return;
+	}
+
+	for (int row = 0; row < canvas.rows(); row++)
+	{
+		translateCells(canvas[row], canvas.cols(), map);
+	}
+}
+
+
+/**
+* Replaces all instances of a character in the canvas.
+*
+* @param canvas[in] Canvas to update
+* @param oldCh The character to be replaced
+* @param newCh The character to replace with
+*/
+void replace(Canvas& canvas, char oldCh, char newCh)
+{
+	char map[CHARSETSIZE];
+	initTranslation(map);
+	map[(unsigned char)oldCh] = newCh;
+	translate(canvas, map);
+}
+
+
+/**
+* Allows user to edit the canvas by moving the cursor
+* around and entering characters until ESC is pressed.
+*
+* @param[in] canvas Array that needs to be updated
+*/
+void editCanvas(Canvas& canvas)
+{
+	char input = 0;
+	int row = 0, col = 0;
+
+	// Move cursor to row,col and then get
+	// a single character from the keyboard
+	gotoxy(row, col);
+	beginKeyInput();
+
+	// Get input from user until ESC is pressed
+	while (input != ESC) {
+		input = getKey();
+
+		// Arrow keys
+		if (input == SPECIAL) {
+
+			input = getKey();
+
+			switch (input) {
+			case LEFTARROW:
+				if (col > 0) col--;
+				break;
+			case RIGHTARROW:
+				if (col < canvas.cols() - 1) col++;
+				break;
+			case UPARROW:
+				if (row > 0) row--;
+				break;
+			case DOWNARROW:
+				if (row < canvas.rows() - 1) row++;
+				break;
+			default:
+				break;
+			}
+		}
+
+		// Ignore the function keys
+		else if (input == '\0') {
+			input = getKey();
+		}
+
+		// Printable ASCII characters
+		else if (input >= 32 && input <= 126) {
+			canvas[row][col] = input;
+			frameWrite(&input, 1);
+		}
+
+		gotoxy(row, col); // Moves cursor to the new position
+	}
+	endKeyInput();
+}
+
+
+// Moves the last shift bytes of a block to its front, and the rest back by shift
+static void rotateBlock(char* block, size_t length, size_t shift)
+{
+	static thread_local vector<char> aside;
+
+	if (shift <= length - shift)
+	{
+		aside.assign(block + length - shift, block + length);
+		memmove(block + shift, block, length - shift);
+		memcpy(block, aside.data(), shift);
+	}
+	else
+	{
+		size_t front = length - shift;
+		aside.assign(block, block + front);
+		memmove(block, block + front, shift);
+		memcpy(block + shift, aside.data(), front);
+	}
+}
+
+
+/**
+* Shifts contents of the canvas by a specified number of rows and columns.
+* Cells shifted off the canvas are lost and the uncovered cells are cleared.
+*
+* @param[in] canvas Canvas to update
+* @param rowValue Number of rows by which to shift
+* @param colValue Number of columns by which to shift
+*/
+void moveCanvas(Canvas& canvas, int rowValue, int colValue)
+{
+	moveCanvas(canvas, rowValue, colValue, false);
+}
+
+
+/**
+* Shifts contents of the canvas in place, one memmove per row.
+*
+* @param[in] canvas Canvas to update
+* @param rowValue Number of rows by which to shift
+* @param colValue Number of columns by which to shift
+* @param wrap true: cells shifted off one edge come back at the opposite edge /
+*             false: they are lost and the uncovered cells are cleared
+*/
+void moveCanvas(Canvas& canvas, int rowValue, int colValue, bool wrap)
+{
+	int rows = canvas.rows();
+	int cols = canvas.cols();
+	if (rows == 0 || cols == 0)
+		return;
+
+	if (wrap)
+	{
+		int shiftRows = ((rowValue % rows) + rows) % rows;
+		int shiftCols = ((colValue % cols) + cols) % cols;
+
+		// Rotating the rows as whole blocks and then each row on its own
+		// moves every cell. Only the smaller side of each rotation is
+		// held aside, which for the usual small steps is a thin band.
+		if (shiftRows != 0)
+		{
+			rotateBlock(canvas.data(), (size_t)rows * canvas.stride(), (size_t)shiftRows * canvas.stride());
+		}
+		if (shiftCols != 0)
+		{
+			for (int row = 0; row < rows; row++)
+			{
+				rotateBlock(canvas[row], cols, shiftCols);
+			}
+		}
+		return;
+	}
+
+	if (abs(rowValue) >= rows || abs(colValue) >= cols)
+	{
+		initCanvas(canvas);
+		return;
+	}
+
+	// Whole rows are contiguous, so a vertical shift is one memmove
+	if (colValue == 0)
+	{
+		size_t keep = (size_t)(rows - abs(rowValue)) * canvas.stride();
+		size_t band = (size_t)abs(rowValue) * canvas.stride();
+		if (rowValue > 0)
+		{
+			memmove(canvas[rowValue], canvas[0], keep);
+			memset(canvas[0], ' ', band);
+		}
+		else if (rowValue < 0)
+		{
+			memmove(canvas[0], canvas[-rowValue], keep);
+			memset(canvas[rows + rowValue], ' ', band);
+		}
+		return;
+	}
+
+	// Part of each row which is still on the canvas after the shift
+	int width = cols - abs(colValue);
+	int fromCol = colValue < 0 ? -colValue : 0;
+	int toCol = colValue > 0 ? colValue : 0;
+	int bandCol = colValue > 0 ? 0 : width;
+
+	// Walk away from the direction of the shift, so each source row
+	// is read before it is overwritten
+	int first = rowValue > 0 ? rows - 1 : 0;
+	int step = rowValue > 0 ? -1 : 1;
+	for (int row = first; row >= 0 && row < rows; row += step)
+	{
+		int from = row - rowValue;
+		if (from < 0 || from >= rows)
+		{
+			memset(canvas[row], ' ', cols);
+		}
+		else
+		{
+			memmove(canvas[row] + toCol, canvas[from] + fromCol, width);
+			memset(canvas[row] + bandCol, ' ', abs(colValue));
+		}
+	}
+}
+
+
+/**
+* Initializes canvas to contain all spaces.
+*
+* @param canvas[in] Canvas to initialize
+*/
+void initCanvas(Canvas& canvas)
+{
+	// Row padding is blank too, so the whole buffer can be cleared at once
+	memset(canvas.data(), ' ', canvas.size());
+}
+
+
+// The canvas as it was last drawn on the screen by displayCanvas
+static Canvas shownCanvas;
+static bool shownValid = false;
+
+// Unchanged gaps shorter than this are redrawn rather than skipped with a cursor move
+const int GAPSIZE = 8;
+
+
+/**
+* Displays canvas contents on the screen, with a border
+* around the right and bottom edges. Only the parts of
+* rows which changed since the last call are redrawn.
+*
+* @param[in] Canvas to display
+*/
+void displayCanvas(const Canvas& canvas)
+{
+	beginFrame();
+
+	if (!shownValid || shownCanvas.rows() != canvas.rows() || shownCanvas.cols() != canvas.cols())
+	{
+		gotoxy(0, 0);
+
+		for (int rowCount = 0; rowCount < canvas.rows(); rowCount++)
+		{
+			frameWrite(canvas[rowCount], canvas.cols());    // Adds the row without any borders
+			frameWrite("|\n");    // Adds the right side of the border
+		}
+
+		string border(canvas.cols(), '-');    // Used for the bottom border of the canvas.
+		border += '\n';
+		frameWrite(border.data(), border.size());
+
+		copyCanvas(shownCanvas, canvas);
+		shownValid = true;
+		endFrame();
+		return;
+	}
+
+	for (int row = 0; row < canvas.rows(); row++)
+	{
+		const char* now = canvas[row];
+		char* shown = shownCanvas[row];
+
+		if (memcmp(now, shown, canvas.cols()) == 0)
+			continue;
+
+		int col = 0;
+		while (col < canvas.cols())
+		{
+			// Find the next changed cell
+			while (col < canvas.cols() && now[col] == shown[col])
+				col++;
+			if (col == canvas.cols())
+				break;
+
+			// Extend the span until a long enough run of unchanged cells
+			int start = col;
+			int end = col;
+			while (col < canvas.cols() && col - end < GAPSIZE)
+			{
+				if (now[col] != shown[col])
+					end = col + 1;
+				col++;
+			}
+
+			gotoxy(row, start);
+			frameWrite(now + start, end - start);
+			memcpy(shown + start, now + start, end - start);
+			col = end;
+		}
+	}
+
+	gotoxy(canvas.rows() + 1, 0);
+	endFrame();
+}
+
+
+/**
+* Makes the next displayCanvas redraw everything.
+*/
+void invalidateDisplay()
+{
+	shownValid = false;
+}
+
+
+/**
+* Makes the next displayCanvas redraw one cell.
+*
+* @param row Row of the cell on the screen
+* @param col Column of the cell on the screen
+*/
+void invalidateDisplay(int row, int col)
+{
+	if (shownValid && shownCanvas.contains(row, col))
+	{
+		// Any value other than the real contents forces a redraw
+		shownCanvas[row][col] = shownCanvas[row][col] == ' ' ? '\0' : ' ';
+	}
+}
+
+
+/**
+* Copies contents of the "from" canvas into the "to" canvas.
+*
+* @param[in] to Canvas to copy
+* @param[in] from Canvas to copy from
+*/
+void copyCanvas(Canvas& to, const Canvas& from)
+{
+	if (to.rows() != from.rows() || to.cols() != from.cols())
+	{
+		to.resize(from.rows(), from.cols());
+	}
+	memcpy(to.data(), from.data(), from.size());
+}
+
+
+// Multipliers of the canvas hash; the same primes xxHash64 uses
+static const uint64_t HASHPRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t HASHPRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t HASHPRIME3 = 0x165667B19E3779F9ULL;
+static const uint64_t HASHPRIME4 = 0x85EBCA77C2B2AE63ULL;
+
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+
+// Mixes one 8-byte word of cells into a hash lane
+static inline uint64_t hashRound(uint64_t lane, const char* cells)
+{
+	uint64_t word;
+	memcpy(&word, cells, sizeof(word));
+	return rotateLeft(lane + word * HASHPRIME2, 31) * HASHPRIME1;
+}
+
+
+/**
+* Hashes the size and cells of a canvas into 64 bits.
+*
+* @param[in] canvas Canvas to hash
+*/
+uint64_t hashCanvas(const Canvas& canvas)
+{
+	const char* cells = canvas.data();
+	size_t size = canvas.size();
+	size_t i = 0;
+
+	// Four independent lanes of 8 bytes each, so the multiplies of one
+	// lane overlap with the others. The row padding always holds spaces,
+	// so the buffer can be hashed as one block.
+	uint64_t lanes[4] = { HASHPRIME1 + HASHPRIME2, HASHPRIME2, 0, 0 - HASHPRIME1 };
+	for (; i + 32 <= size; i += 32)
+	{
+		lanes[0] = hashRound(lanes[0], cells + i);
+		lanes[1] = hashRound(lanes[1], cells + i + 8);
+		lanes[2] = hashRound(lanes[2], cells + i + 16);
+		lanes[3] = hashRound(lanes[3], cells + i + 24);
+	}
+	uint64_t hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+
+	// Rows are padded to CANVASALIGN bytes, so the rest is whole words
+	for (; i + 8 <= size; i += 8)
+	{
+		hash = rotateLeft(hash ^ hashRound(0, cells + i), 27) * HASHPRIME1 + HASHPRIME4;
+	}
+	for (; i < size; i++)
+	{
+		hash = rotateLeft(hash ^ ((unsigned char)cells[i] * HASHPRIME3), 11) * HASHPRIME1;
+	}
+
+	// The size keeps canvases with the same cells in a different shape apart
+	hash ^= ((uint64_t)(unsigned)canvas.rows() << 32) | (unsigned)canvas.cols();
+	hash ^= hash >> 33;
+	hash *= HASHPRIME2;
+	hash ^= hash >> 29;
+	hash *= HASHPRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+
+/**
+* Compares two canvases, reading their cells only if their hashes match.
+*
+* @param[in] a First canvas
+* @param[in] hashA hashCanvas value of a
+* @param[in] b Second canvas
+* @param[in] hashB hashCanvas value of b
+*/
+bool sameCanvas(const Canvas& a, uint64_t hashA, const Canvas& b, uint64_t hashB)
+{
+	if (hashA != hashB || a.rows() != b.rows() || a.cols() != b.cols())
+		return false;
+	return a.size() == 0 || memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+
+// Appends one row to a save buffer, without its trailing spaces unless fixedWidth is set
+static void appendRow(string& out, const char* row, int cols, bool fixedWidth)
+{
+	int length = cols;
+	if (!fixedWidth)
+	{
+		while (length > 0 && row[length - 1] == ' ')
+			length--;
+	}
+	out.append(row, length);
+	out += '\n';
+}
+
+
+/**
+* Writes data into a file through a temporary file in the same directory,
+* so the file at path is either the old one or the complete new one.
+*
+* @param path File to write
+* @param data Bytes to write
+* @param length Number of bytes to write
+*/
+bool writeFileAtomic(const char* path, const char* data, size_t length)
+{
+	char tempPath[FILENAMESIZE];
+	if (snprintf(tempPath, FILENAMESIZE, "%s.tmp", path) >= FILENAMESIZE)
+	{
+		return false;
+	}
+
+#ifdef _WIN32
+	int file = _open(tempPath, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	int file = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+	if (file < 0)
+	{
+		return false;
+	}
+
+	bool failed = false;
+	while (length > 0 && !failed)
+	{
+#ifdef _WIN32
+		long written = _write(file, data, (unsigned)min(length, (size_t)INT_MAX));
+#else
+		long written = (long)write(file, data, length);
+#endif
+		failed = written <= 0;
+		if (!failed)
+		{
+			data += written;
+			length -= written;
+		}
+	}
+
+	// The data has to be on disk before the rename makes it the saved file
+#ifdef _WIN32
+	failed = _commit(file) != 0 || failed;
+	failed = _close(file) != 0 || failed;
+	failed = failed || !MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	failed = fsync(file) != 0 || failed;
+	failed = close(file) != 0 || failed;
+	failed = failed || rename(tempPath, path) != 0;
+#endif
+
+	if (failed)
+	{
+		remove(tempPath);
+	}
+	return !failed;
+}
+
+
+static bool readFile(const char* filename, vector<char>& data, size_t& length);
+
+// Longest literal run and longest repeat run one control byte describes
+const int MAXLITERAL = 128;
+const int MINREPEAT = 3;
+const int MAXREPEAT = MINREPEAT + 127;
+
+// Since version 2, every frame after the first starts with its kind: run-length
+// encoded rows, or the runs of cells which changed since the frame before
+const char FULLFRAME = 0;
+const char DIFFFRAME = 1;
+
+
+// Returns true if filename ends with extension
+static bool endsWith(const char filename[], const char extension[])
+{
+	size_t length = strlen(filename);
+	size_t extensionLength = strlen(extension);
+	return length >= extensionLength && strcmp(filename + length - extensionLength, extension) == 0;
+}
+
+
+bool isBinaryCanvasFile(const char filename[])
+{
+	return endsWith(filename, BINARYEXTENSION);
+}
+
+
+bool hasCanvasExtension(const char filename[])
+{
+	return endsWith(filename, TEXTEXTENSION) || endsWith(filename, BINARYEXTENSION);
+}
+
+
+// Appends the low bytes of a value, low byte first
+static void appendValue(string& out, unsigned long value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+	{
+		out += (char)((value >> (8 * i)) & 0xFF);
+	}
+}
+
+
+// Reads a value written by appendValue
+static unsigned long readValue(const char* p, int bytes)
+{
+	unsigned long value = 0;
+	for (int i = bytes - 1; i >= 0; i--)
+	{
+		value = (value << 8) | (unsigned char)p[i];
+	}
+	return value;
+}
+
+
+/*
+* Appends one row in run-length encoding. Each run starts with a control byte:
+* 0-127 is followed by that many plus one cells copied as they are, and
+* 128-255 by one cell repeated (control - 128 + MINREPEAT) times.
+*/
+static void appendEncodedRow(string& out, const char* row, int cols)
+{
+	int col = 0;
+	while (col < cols)
+	{
+		int run = 1;
+		while (col + run < cols && run < MAXREPEAT && row[col + run] == row[col])
+			run++;
+
+		if (run >= MINREPEAT)
+		{
+			out += (char)(0x80 + run - MINREPEAT);
+			out += row[col];
+			col += run;
+			continue;
+		}
+
+		// Collect cells up to the next run worth encoding
+		int start = col;
+		while (col < cols && col - start < MAXLITERAL)
+		{
+			if (col + 2 < cols && row[col] == row[col + 1] && row[col] == row[col + 2])
+				break;
+			col++;
+		}
+		out += (char)(col - start - 1);
+		out.append(row + start, col - start);
+	}
+}
+
+
+/*
+* Decodes one row of fileCols cells from the data at src into a blank row,
+* keeping the first cols of them. Returns a pointer past the row's data, or NULL if the
+* data ends early or its runs do not add up to fileCols.
+*/
+static const char* decodeRow(char* row, int cols, int fileCols, const char* src, const char* end)
+{
+	int col = 0;
+	while (col < fileCols)
+	{
+		if (src >= end)
+			return NULL;
+
+		int control = (unsigned char)*src++;
+		if (control < 0x80)
+		{
+			int run = control + 1;
+			if (run > fileCols - col || run > end - src)
+				return NULL;
+			if (col < cols)
+				memcpy(row + col, src, min(run, cols - col));
+			src += run;
+			col += run;
+		}
+		else
+		{
+			int run = control - 0x80 + MINREPEAT;
+			if (run > fileCols - col || src >= end)
+				return NULL;
+			// The row starts out blank, so runs of spaces are skipped
+			if (col < cols && *src != ' ')
+				memset(row + col, *src, min(run, cols - col));
+			src++;
+			col += run;
+		}
+	}
+	return src;
+}
+
+
+// Checks the header of a binary canvas file and reads its size; returns false if
+// it is not one, or if the data after it is too short for the frames it counts
+static bool readBinaryHeader(const char* data, size_t size, int& rows, int& cols, int& frames)
+{
+	if (size < (size_t)BINARYHEADERSIZE || memcmp(data, BINARYMAGIC, 4) != 0 || data[4] < 1 || data[4] > BINARYVERSION)
+	{
+		return false;
+	}
+	rows = (int)readValue(data + 6, 2);
+	cols = (int)readValue(data + 8, 2);
+	frames = (int)readValue(data + 10, 4);
+	if (frames < 0 || (frames > 0 && (rows < 1 || cols < 1)))
+	{
+		return false;
+	}
+
+	// Every encoded row takes at least a control byte and a cell; since version 2
+	// a frame after the first may instead be its kind and a count of no runs
+	size_t smallestFrame = 2 * (size_t)rows;
+	if (data[4] >= 2)
+	{
+		smallestFrame = min(smallestFrame, (size_t)5);
+	}
+	return frames == 0 || (size_t)frames <= (size - BINARYHEADERSIZE) / smallestFrame;
+}
+
+
+/*
+* Loads one frame of fileRows x fileCols cells from src the same way loadCanvas
+* loads text: cells which do not fit are dropped and the rest of the canvas is
+* left blank. Returns a pointer past the frame, or NULL if the data is damaged.
+*/
+static const char* loadBinaryFrame(Canvas& canvas, int fileRows, int fileCols, const char* src, const char* end, LoadStats& stats)
+{
+	initCanvas(canvas);
+
+	for (int row = 0; row < fileRows && src != NULL; row++)
+	{
+		bool fits = row < canvas.rows();
+		src = decodeRow(fits ? canvas[row] : NULL, fits ? canvas.cols() : 0, fileCols, src, end);
+
+		stats.lines++;
+		if (!fits)
+		{
+			stats.droppedLines++;
+		}
+		else if (fileCols > canvas.cols())
+		{
+			stats.truncatedLines++;
+			stats.droppedChars += fileCols - canvas.cols();
+		}
+	}
+	return src;
+}
+
+
+// Appends the runs of a diff: their number, then each run's row, column and
+// length, which take DIFFRUNHEADERSIZE bytes, and its new cells encoded like a row
+static void appendDiff(string& out, const CanvasDiff& diff)
+{
+	appendValue(out, (unsigned long)diff.runs.size(), 4);
+	const char* cells = diff.after.data();
+	for (size_t i = 0; i < diff.runs.size(); i++)
+	{
+		const CellRun& run = diff.runs[i];
+		appendValue(out, run.row, 2);
+		appendValue(out, run.col, 2);
+		appendValue(out, run.length, 2);
+		appendEncodedRow(out, cells, run.length);
+		cells += run.length;
+	}
+}
+
+
+/*
+* Writes runs appended by appendDiff into canvas, which holds the frame before.
+* Returns a pointer past the runs, or NULL if the data is damaged.
+*/
+static const char* loadDiffFrame(Canvas& canvas, const char* src, const char* end)
+{
+	if (end - src < 4)
+		return NULL;
+	unsigned long count = readValue(src, 4);
+	src += 4;
+
+	for (unsigned long i = 0; i < count; i++)
+	{
+		if (end - src < DIFFRUNHEADERSIZE)
+			return NULL;
+		int row = (int)readValue(src, 2);
+		int col = (int)readValue(src + 2, 2);
+		int length = (int)readValue(src + 4, 2);
+		src += DIFFRUNHEADERSIZE;
+
+		if (row >= canvas.rows() || col + length > canvas.cols())
+			return NULL;
+
+		// decodeRow leaves runs of spaces out, so the cells start blank
+		memset(canvas[row] + col, ' ', length);
+		src = decodeRow(canvas[row] + col, length, length, src, end);
+		if (src == NULL)
+			return NULL;
+	}
+	return src;
+}
+
+
+// Builds a binary canvas file holding count frames of the same size
+static void encodeFrames(string& out, const Canvas* const frames[], int count)
+{
+	static thread_local string frame;
+	static thread_local string changes;
+	static thread_local CanvasDiff diff;
+
+	int rows = count > 0 ? frames[0]->rows() : 0;
+	int cols = count > 0 ? frames[0]->cols() : 0;
+
+	out.append(BINARYMAGIC, 4);
+	out += (char)BINARYVERSION;
+	out += (char)0;
+	appendValue(out, rows, 2);
+	appendValue(out, cols, 2);
+	appendValue(out, count, 4);
+	for (int i = 0; i < count; i++)
+	{
+		frame.clear();
+		for (int x = 0; x < rows; x++)
+		{
+			appendEncodedRow(frame, (*frames[i])[x], cols);
+		}
+
+		// Each frame is stored whichever way is smaller
+		if (i > 0)
+		{
+			diffCanvas(*frames[i - 1], *frames[i], diff);
+			changes.clear();
+			appendDiff(changes, diff);
+			if (changes.size() < frame.size())
+			{
+				out += DIFFFRAME;
+				out += changes;
+				continue;
+			}
+			out += FULLFRAME;
+		}
+		out += frame;
+	}
+}
+
+
+/**
+* Writes several canvases of the same size into one binary canvas file.
+*
+* @param frames Canvases to write, in order
+* @param count Number of canvases
+* @param path File to write
+*/
+bool writeFramesFile(const Canvas* const frames[], int count, const char* path)
+{
+	for (int i = 1; i < count; i++)
+	{
+		if (frames[i]->rows() != frames[0]->rows() || frames[i]->cols() != frames[0]->cols())
+			return false;
+	}
+	if (count > 0 && (frames[0]->rows() > 0xFFFF || frames[0]->cols() > 0xFFFF))
+	{
+		return false;
+	}
+
+	string out;
+	encodeFrames(out, frames, count);
+	return writeFileAtomic(path, out.data(), out.size());
+}
+
+
+/**
+* Loads every frame of a binary canvas file, each into a canvas of the
+* size stored in the file.
+*
+* @param[out] frames Canvases loaded, in order
+* @param filename Path of the file
+*/
+bool loadFrames(vector<Canvas>& frames, char filename[])
+{
+	static thread_local vector<char> data;
+	size_t size;
+	int rows, cols, count;
+
+	frames.clear();
+	if (!readFile(filename, data, size) || !readBinaryHeader(data.data(), size, rows, cols, count))
+	{
+		return false;
+	}
+
+	frames.reserve(count);
+	int version = data[4];
+	const char* src = data.data() + BINARYHEADERSIZE;
+	const char* end = data.data() + size;
+	LoadStats stats;
+	for (int i = 0; i < count && src != NULL; i++)
+	{
+		char kind = FULLFRAME;
+		if (version >= 2 && i > 0)
+		{
+			kind = src < end ? *src++ : -1;
+		}
+
+		if (kind == DIFFFRAME)
+		{
+			Canvas frame = frames.back();
+			frames.push_back(move(frame));
+			src = loadDiffFrame(frames.back(), src, end);
+		}
+		else if (kind == FULLFRAME)
+		{
+			frames.push_back(Canvas(rows, cols));
+			src = loadBinaryFrame(frames.back(), rows, cols, src, end, stats);
+		}
+		else
+		{
+			src = NULL;
+		}
+
+		if (src == NULL)
+		{
+			frames.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+* Writes a canvas into a file, choosing the format by the extension of path.
+*
+* @param canvas[in] Canvas to write
+* @param path File to write
+* @param fixedWidth true: write text rows at full width / false: trim trailing spaces
+*/
+bool writeCanvasFile(const Canvas& canvas, const char* path, bool fixedWidth)
+{
+	// The whole file is built in memory and written with one call
+	static thread_local string out;
+	out.clear();
+
+	if (isBinaryCanvasFile(path))
+	{
+		const Canvas* frames[] = { &canvas };
+		return writeFramesFile(frames, 1, path);
+	}
+
+	out.reserve((size_t)canvas.rows() * (canvas.cols() + 1));
+	for (int x = 0; x < canvas.rows(); x++)
+	{
+		appendRow(out, canvas[x], canvas.cols(), fixedWidth);
+	}
+	return writeFileAtomic(path, out.data(), out.size());
+}
+
+
+/**
+* Gets a filename from the user. If file can be opened for writing,
+* writes the canvas contents into the file.
+*
+* @param canvas[in] Canvas to save
+* @param filename Name of the file in SavedFiles; ".txt" is added if it has no extension
+* @param fixedWidth true: write rows at full width / false: trim trailing spaces
+*/
+bool saveCanvas(const Canvas& canvas, char filename[], bool fixedWidth)
+{
+	char directory[FILENAMESIZE] = "SavedFiles";    //Creates the directory used to make sure we have the correct filepath
+
+	char filePath[FILENAMESIZE];
+	int length = snprintf(filePath, FILENAMESIZE, "%s/%s%s", directory, filename, hasCanvasExtension(filename) ? "" : TEXTEXTENSION);
+	if (length < 0 || length >= FILENAMESIZE)
+	{
+		return false;
+	}
+
+	return writeCanvasFile(canvas, filePath, fixedWidth);
+}
+
+
+/**
+* Saves the canvas into SavedFiles with trailing spaces trimmed.
+*
+* @param canvas[in] Canvas to save
+* @param filename Name of the file in SavedFiles, without ".txt"
+*/
+bool saveCanvas(const Canvas& canvas, char filename[])
+{
+	return saveCanvas(canvas, filename, false);
+}
+
+
+// Smallest buffer readFile starts with; clips fit in one read
+const size_t READCHUNK = 64 * 1024;
+
+
+// Reads a whole file into the front of data with as few calls as possible and
+// sets length to its size; returns false if it cannot be read
+static bool readFile(const char* filename, vector<char>& data, size_t& length)
+{
+#ifdef _WIN32
+	int file = _open(filename, _O_RDONLY | _O_BINARY);
+#else
+	int file = open(filename, O_RDONLY);
+#endif
+	if (file < 0)
+	{
+		return false;
+	}
+
+	// A regular file only returns less than was asked for at its end,
+	// so a file smaller than the buffer takes a single read
+	if (data.size() < READCHUNK)
+		data.resize(READCHUNK);
+
+	length = 0;
+	bool failed = false;
+	while (true)
+	{
+		if (length == data.size())
+			data.resize(data.size() * 2);
+
+		size_t wanted = data.size() - length;
+#ifdef _WIN32
+		long got = _read(file, data.data() + length, (unsigned)min(wanted, (size_t)INT_MAX));
+#else
+		long got = (long)read(file, data.data() + length, wanted);
+#endif
+		if (got < 0)
+		{
+			failed = true;
+			break;
+		}
+		length += got;
+		if ((size_t)got < wanted)
+			break;
+	}
+
+#ifdef _WIN32
+	_close(file);
+#else
+	close(file);
+#endif
+	return !failed;
+}
+
+
+// Copies one line into a canvas row, expanding tabs to the next tab stop
+static void loadLine(char* row, int cols, const char* line, size_t length, LoadStats& stats)
+{
+	const char* tab = (const char*)memchr(line, '\t', length);
+	if (tab == NULL)
+	{
+		size_t fits = min(length, (size_t)cols);
+		memcpy(row, line, fits);
+		if (length > fits)
+		{
+			stats.truncatedLines++;
+			stats.droppedChars += length - fits;
+		}
+		return;
+	}
+
+	// Copy the plain runs between tabs and skip ahead over each tab;
+	// the row is already blank, so a tab leaves spaces behind
+	size_t col = 0;
+	const char* end = line + length;
+	while (line < end)
+	{
+		if (tab == NULL)
+			tab = end;
+
+		size_t run = tab - line;
+		if (col < (size_t)cols)
+			memcpy(row + col, line, min(run, cols - col));
+		col += run;
+
+		if (tab < end)
+		{
+			stats.tabs++;
+			col += TABSIZE - col % TABSIZE;
+			tab++;
+		}
+		line = tab;
+		tab = (const char*)memchr(line, '\t', end - line);
+	}
+
+	if (col > (size_t)cols)
+	{
+		stats.truncatedLines++;
+		stats.droppedChars += col - cols;
+	}
+}
+
+
+/**
+* Loads a TXT file into canvas. The file is read with one call and
+* split into lines with memchr, and each line is copied into its row.
+*
+* @param[in] canvas Canvas to load
+* @param filename Path of the file
+* @param[out] stats What did not fit into the canvas
+*/
+bool loadCanvas(Canvas& canvas, char filename[], LoadStats& stats)
+{
+	// Kept between calls so loading a run of clips reuses one allocation;
+	// one per thread, so batch scripts can load files side by side
+	static thread_local vector<char> data;
+	size_t size;
+
+	stats = LoadStats();
+	if (!readFile(filename, data, size))
+	{
+		return false;
+	}
+
+	// A binary file loads its first frame
+	if (isBinaryCanvasFile(filename))
+	{
+		int fileRows, fileCols, frames;
+		if (!readBinaryHeader(data.data(), size, fileRows, fileCols, frames))
+		{
+			return false;
+		}
+		if (frames == 0)
+		{
+			initCanvas(canvas);
+			return true;
+		}
+		return loadBinaryFrame(canvas, fileRows, fileCols, data.data() + BINARYHEADERSIZE, data.data() + size, stats) != NULL;
+	}
+
+	initCanvas(canvas);
+
+	const char* next = data.data();
+	const char* end = next + size;
+	int row = 0;
+	while (next < end)
+	{
+		const char* newline = (const char*)memchr(next, '\n', end - next);
+		const char* lineEnd = newline != NULL ? newline : end;
+
+		// Files saved on Windows end their lines with CRLF
+		size_t lineLength = lineEnd - next;
+		if (lineLength > 0 && next[lineLength - 1] == '\r')
+		{
+			lineLength--;
+		}
+
+		stats.lines++;
+		if (row < canvas.rows())
+		{
+			loadLine(canvas[row], canvas.cols(), next, lineLength, stats);
+			row++;
+		}
+		else
+		{
+			stats.droppedLines++;
+		}
+
+		next = newline != NULL ? newline + 1 : end;
+	}
+	return true;
+}
+
+
+/**
+* Loads a TXT file into canvas, ignoring whatever does not fit.
+*
+* @param[in] canvas Canvas to load
+* @param filename Path of the file
+*/
+bool loadCanvas(Canvas& canvas, char filename[])
+{
+	LoadStats stats;
+	return loadCanvas(canvas, filename, stats);
+}
+
+
+/**
+* Finds the size of the canvas a file holds.
+*
+* @param filename Path of the file
+* @param[out] rows Number of rows in the file
+* @param[out] cols Number of columns in the file
+*/
+bool canvasFileSize(char filename[], int& rows, int& cols)
+{
+	static thread_local vector<char> data;
+	size_t size;
+	if (!readFile(filename, data, size))
+	{
+		return false;
+	}
+
+	if (isBinaryCanvasFile(filename))
+	{
+		int frames;
+		return readBinaryHeader(data.data(), size, rows, cols, frames);
+	}
+
+	// Widths are measured the way loadCanvas lays lines out
+	rows = 0;
+	cols = 0;
+	const char* next = data.data();
+	const char* end = next + size;
+	while (next < end)
+	{
+		const char* newline = (const char*)memchr(next, '\n', end - next);
+		const char* lineEnd = newline != NULL ? newline : end;
+		if (lineEnd > next && lineEnd[-1] == '\r')
+			lineEnd--;
+
+		int width = 0;
+		for (const char* p = next; p < lineEnd; p++)
+		{
+			width = *p == '\t' ? width + TABSIZE - width % TABSIZE : width + 1;
+		}
+
+		rows++;
+		cols = max(cols, width);
+		next = newline != NULL ? newline + 1 : end;
+	}
+	return true;
+}
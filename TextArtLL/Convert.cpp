@@ -0,0 +1,276 @@
+/*
+* Checks, normalizes and converts canvas files in bulk. Files and whole
+* directory trees are processed on all cores, and every file which fails
+* is reported along with the total throughput.
+*
+* Converted files are written next to the original with the other
+* extension, loaded back and compared before they count as converted.
+* Normalized text files are rewritten in place, trimmed or at full width.
+* Images become text canvases of a fixed size, so numbered frame dumps
+* (frame-1.ppm, frame-2.ppm, ...) turn into a clip set loadClips reads.
+*
+* Usage: TextArtConvert [mode] [--fixed] [-j threads] path...
+*   (no mode)     convert .txt files to .rle
+*   --to-text     convert .rle files to .txt
+*   --check       only check that .txt and .rle files load and fit the editor
+*   --normalize   rewrite .txt files with trailing spaces trimmed
+*   --image       convert .pgm and .ppm images to .txt
+*   --size RxC    canvas size for images (default: MAXROWS x MAXCOLS)
+*   --ramp CHARS  characters from black to white for images (default: DEFAULTRAMP)
+*   --fixed       write text rows at full width, at least MAXCOLS wide
+*   -j threads    number of threads (default: one per core)
+*/
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <filesystem>
+#include "Definitions.h"
+using namespace std;
+
+
+enum Mode { TOBINARY, TOTEXT, CHECK, NORMALIZE, FROMIMAGE };
+
+// Size of the canvas images are converted to, and the characters used
+static int imageRows = MAXROWS;
+static int imageCols = MAXCOLS;
+static string imageRamp = DEFAULTRAMP;
+
+
+// Counts what the files processed so far held
+struct Totals
+{
+	atomic<int> files{ 0 };
+	atomic<int> failed{ 0 };
+	atomic<long long> bytesIn{ 0 };
+	atomic<long long> bytesOut{ 0 };
+};
+
+
+// Returns true if every cell of the canvas is a printable character
+static bool printable(const Canvas& canvas, int& row, int& col)
+{
+	for (row = 0; row < canvas.rows(); row++)
+	{
+		for (col = 0; col < canvas.cols(); col++)
+		{
+			unsigned char ch = (unsigned char)canvas[row][col];
+			if (ch < 32 || ch > 126)
+				return false;
+		}
+	}
+	return true;
+}
+
+
+// Processes one file; returns false and sets error if it fails
+static bool processFile(const string& from, Mode mode, bool fixedWidth, Totals& totals, string& error)
+{
+	char fromPath[FILENAMESIZE];
+	char toPath[FILENAMESIZE];
+	string to = from;
+	if (mode == TOBINARY || mode == TOTEXT || mode == FROMIMAGE)
+		to = filesystem::path(from).replace_extension(mode == TOBINARY ? BINARYEXTENSION : TEXTEXTENSION).string();
+	if (from.size() >= FILENAMESIZE || to.size() >= FILENAMESIZE)
+	{
+		error = "path too long";
+		return false;
+	}
+	snprintf(fromPath, FILENAMESIZE, "%s", from.c_str());
+	snprintf(toPath, FILENAMESIZE, "%s", to.c_str());
+
+	int rows = imageRows;
+	int cols = imageCols;
+	if (mode != FROMIMAGE && !canvasFileSize(fromPath, rows, cols))
+	{
+		error = "cannot be read or is not a canvas file";
+		return false;
+	}
+	// Images are not opened before this, so a missing one is found here; an
+	// exception thrown on a worker thread would end the whole tool
+	error_code failure;
+	uintmax_t bytesIn = filesystem::file_size(from, failure);
+	if (failure)
+	{
+		error = "cannot be read";
+		return false;
+	}
+	totals.bytesIn += (long long)bytesIn;
+
+	// Full-width text is padded out to what the editor shows
+	if (fixedWidth && mode != CHECK && mode != FROMIMAGE)
+	{
+		rows = max(rows, MAXROWS);
+		cols = max(cols, MAXCOLS);
+	}
+
+	// Files already run in parallel, so each image is converted on one thread
+	Canvas canvas(rows, cols);
+	LoadStats stats;
+	if (mode == FROMIMAGE ? !loadImageCanvas(canvas, fromPath, imageRamp.c_str(), 1) : !loadCanvas(canvas, fromPath, stats))
+	{
+		error = "damaged or cannot be read";
+		return false;
+	}
+
+	if (mode == CHECK)
+	{
+		int row, col;
+		if (!printable(canvas, row, col))
+		{
+			error = "control character at row " + to_string(row + 1) + ", column " + to_string(col + 1);
+			return false;
+		}
+		if (rows > MAXROWS || cols > MAXCOLS)
+		{
+			error = to_string(rows) + " x " + to_string(cols) + " does not fit the " +
+				to_string(MAXROWS) + " x " + to_string(MAXCOLS) + " editor canvas";
+			return false;
+		}
+		return true;
+	}
+
+	if (!writeCanvasFile(canvas, toPath, fixedWidth))
+	{
+		error = string(toPath) + " cannot be written";
+		return false;
+	}
+
+	Canvas check(rows, cols);
+	if (!loadCanvas(check, toPath) || memcmp(canvas.data(), check.data(), canvas.size()) != 0)
+	{
+		error = string(toPath) + " does not load back the same";
+		return false;
+	}
+	uintmax_t bytesOut = filesystem::file_size(to, failure);
+	if (failure)
+	{
+		error = string(toPath) + " cannot be read back";
+		return false;
+	}
+	totals.bytesOut += (long long)bytesOut;
+	return true;
+}
+
+
+// Adds path, or every file under it if it is a directory, when it has one of the extensions
+static void addFiles(const string& path, const vector<string>& extensions, vector<string>& files)
+{
+	error_code failure;
+	if (!filesystem::is_directory(path, failure))
+	{
+		files.push_back(path);
+		return;
+	}
+
+	filesystem::recursive_directory_iterator entry(path, filesystem::directory_options::skip_permission_denied, failure);
+	for (; !failure && entry != filesystem::recursive_directory_iterator(); entry.increment(failure))
+	{
+		if (entry->is_regular_file(failure) &&
+			find(extensions.begin(), extensions.end(), entry->path().extension().string()) != extensions.end())
+		{
+			files.push_back(entry->path().string());
+		}
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	Mode mode = TOBINARY;
+	bool fixedWidth = false;
+	int threads = 0;
+	vector<string> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--to-text") == 0)
+			mode = TOTEXT;
+		else if (strcmp(argv[i], "--check") == 0)
+			mode = CHECK;
+		else if (strcmp(argv[i], "--normalize") == 0)
+			mode = NORMALIZE;
+		else if (strcmp(argv[i], "--image") == 0)
+			mode = FROMIMAGE;
+		else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+		{
+			if (sscanf(argv[++i], "%dx%d", &imageRows, &imageCols) != 2 ||
+				imageRows < 1 || imageCols < 1 || imageRows > 0xFFFF || imageCols > 0xFFFF)
+			{
+				printf("%s: not a canvas size such as 22x80\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--ramp") == 0 && i + 1 < argc)
+			imageRamp = argv[++i];
+		else if (strcmp(argv[i], "--fixed") == 0)
+			fixedWidth = true;
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else
+			paths.push_back(argv[i]);
+	}
+
+	vector<string> extensions;
+	if (mode == FROMIMAGE)
+	{
+		extensions.push_back(".pgm");
+		extensions.push_back(".ppm");
+	}
+	else if (mode != TOTEXT)
+		extensions.push_back(TEXTEXTENSION);
+	if (mode == TOTEXT || mode == CHECK)
+		extensions.push_back(BINARYEXTENSION);
+
+	// Files named directly are only skipped if they have the wrong extension
+	vector<string> files;
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		addFiles(paths[i], extensions, files);
+	}
+	files.erase(remove_if(files.begin(), files.end(), [&](const string& file)
+		{
+			return find(extensions.begin(), extensions.end(), filesystem::path(file).extension().string()) == extensions.end();
+		}), files.end());
+	sort(files.begin(), files.end());
+	files.erase(unique(files.begin(), files.end()), files.end());
+
+	if (files.empty())
+	{
+		printf("Usage: TextArtConvert [--to-text | --check | --normalize] [--fixed] [-j threads] path...\n");
+		printf("       TextArtConvert --image [--size RxC] [--ramp chars] [--fixed] [-j threads] path...\n");
+		return 1;
+	}
+
+	Totals totals;
+	mutex output;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	runParallel(files.size(), threads, [&](size_t job)
+	{
+		string error;
+		totals.files++;
+		if (!processFile(files[job], mode, fixedWidth, totals, error))
+		{
+			totals.failed++;
+			lock_guard<mutex> lock(output);
+			printf("%s: %s\n", files[job].c_str(), error.c_str());
+		}
+	});
+
+	double seconds = max(chrono::duration<double>(chrono::steady_clock::now() - start).count(), 1e-9);
+	int done = totals.files - totals.failed;
+	const char* verb = mode == CHECK ? "passed" : mode == NORMALIZE ? "normalized" : "converted";
+	printf("%d of %d files %s in %.3f s: %.0f files/s, %.2f MB/s read",
+		done, (int)totals.files, verb, seconds, totals.files / seconds, totals.bytesIn / seconds / 1e6);
+	if (mode != CHECK)
+		printf(", %lld bytes to %lld bytes", (long long)totals.bytesIn, (long long)totals.bytesOut);
+	printf("\n");
+	return totals.failed == 0 ? 0 : 1;
+}
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
 const int MAXROWS = 22;
 const int MAXCOLS = 80;
 const int BUFFERSIZE = 20;
@@ -13,14 +19,237 @@ const char RIGHTARROW = 77;
 const char DOWNARROW = 80;
 const char SPECIAL = (char)224;
 
-// Type definition to define the data type for the data items in a linked list
-typedef char ListItemType[MAXROWS][MAXCOLS];
+// Rows of a canvas are padded to a multiple of this many bytes
+const int CANVASALIGN = 16;
+
+// Number of entries in a translation map (one per char value)
+const int CHARSETSIZE = 256;
+
+// Largest number of changed characters translateCells handles with vector compares
+const int MAXSIMDPAIRS = 16;
+
+// Columns between tab stops when a loaded file contains tabs
+const int TABSIZE = 8;
+
+// Canvas files are text unless their name ends with BINARYEXTENSION
+const char TEXTEXTENSION[] = ".txt";
+const char BINARYEXTENSION[] = ".rle";
+
+// Start of every binary canvas file, and the format version written after it;
+// files of every version up to BINARYVERSION can be read
+const char BINARYMAGIC[] = "TART";
+const int BINARYVERSION = 2;
+
+// Bytes in the header of a binary canvas file: magic, version, flags, rows, cols and frames
+const int BINARYHEADERSIZE = 14;
+
+// Bytes each run of a diff frame takes in a binary canvas file besides its
+// cells: its row, column and length. Part of the file format.
+const int DIFFRUNHEADERSIZE = 6;
+
+// Unchanged cells between two changed ones which a canvas diff keeps in one run
+const int MINDIFFGAP = 6;
+
+/*
+* A drawing canvas whose size is chosen at runtime. The cells are stored
+* row-major in one contiguous buffer, and each row starts stride() bytes
+* after the previous one. The padding at the end of each row always holds
+* spaces, so whole-canvas operations can work on the buffer as a single block.
+* canvas[row][col] accesses a single cell.
+*/
+class Canvas
+{
+public:
+	// An empty canvas with no rows or columns
+	Canvas() { numRows = 0; numCols = 0; rowStride = 0; }
+	// A blank canvas with the given number of rows and columns
+	Canvas(int rows, int cols) { numRows = 0; numCols = 0; rowStride = 0; resize(rows, cols); }
+
+	int rows() const { return numRows; }
+	int cols() const { return numCols; }
+	int stride() const { return rowStride; }
+
+	// Number of bytes in the buffer, including row padding
+	size_t size() const { return cells.size(); }
+
+	char* data() { return cells.data(); }
+	const char* data() const { return cells.data(); }
+
+	char* operator[](int row) { return cells.data() + (size_t)row * rowStride; }
+	const char* operator[](int row) const { return cells.data() + (size_t)row * rowStride; }
+
+	// Returns true if (row, col) is a cell of the canvas
+	bool contains(int row, int col) const { return row >= 0 && row < numRows && col >= 0 && col < numCols; }
+
+	/*
+	* Changes the dimensions of the canvas. The contents are not kept;
+	* the canvas is left containing all spaces.
+	*/
+	void resize(int rows, int cols);
+
+private:
+	int numRows, numCols, rowStride;
+	std::vector<char> cells;
+};
+
+// Width and height of one tile of a TiledCanvas
+const int TILESIZE = 64;
+
+/*
+* A sparse canvas for very large, mostly blank drawings. The canvas is split
+* into TILESIZE x TILESIZE tiles, and a tile only gets its own storage the
+* first time a non-space character is written into it. All other tiles read
+* from one shared blank tile, so memory use and the cost of copying, moving
+* and saving scale with the inked area instead of the canvas size.
+*/
+class TiledCanvas
+{
+public:
+	// An empty canvas with no rows or columns
+	TiledCanvas() { numRows = 0; numCols = 0; numTileRows = 0; numTileCols = 0; }
+	// A blank canvas with the given number of rows and columns
+	TiledCanvas(int rows, int cols) { numRows = 0; numCols = 0; numTileRows = 0; numTileCols = 0; resize(rows, cols); }
+
+	int rows() const { return numRows; }
+	int cols() const { return numCols; }
+	int tileRows() const { return numTileRows; }
+	int tileCols() const { return numTileCols; }
+
+	// Returns true if (row, col) is a cell of the canvas
+	bool contains(int row, int col) const { return row >= 0 && row < numRows && col >= 0 && col < numCols; }
+
+	// Returns the character at (row, col), which must be inside the canvas
+	char get(int row, int col) const
+	{
+		const std::vector<char>& t = tiles[(row / TILESIZE) * numTileCols + col / TILESIZE];
+		return t.empty() ? ' ' : t[(row % TILESIZE) * TILESIZE + col % TILESIZE];
+	}
+
+	// Stores ch at (row, col), which must be inside the canvas
+	void set(int row, int col, char ch);
+
+	// Returns true if the tile has its own storage
+	bool hasTile(int tileRow, int tileCol) const { return !tiles[tileRow * numTileCols + tileCol].empty(); }
+
+	/*
+	* Returns the TILESIZE x TILESIZE cells of a tile, row-major.
+	* A tile without its own storage returns the shared blank tile.
+	*/
+	const char* tile(int tileRow, int tileCol) const;
+
+	// Returns the cells of a tile for writing, giving the tile its own storage if needed
+	char* writableTile(int tileRow, int tileCol);
+
+	// Drops the storage of a tile, making it blank again
+	void releaseTile(int tileRow, int tileCol) { std::vector<char>().swap(tiles[tileRow * numTileCols + tileCol]); }
+
+	// Makes every cell blank and frees all tile storage
+	void clear();
+
+	/*
+	* Changes the dimensions of the canvas. The contents are not kept;
+	* the canvas is left containing all spaces.
+	*/
+	void resize(int rows, int cols);
+
+	// Number of tiles which have their own storage
+	int allocatedTiles() const;
+
+	// Number of bytes used by the cells of allocated tiles
+	size_t memoryUsed() const { return (size_t)allocatedTiles() * TILESIZE * TILESIZE; }
+
+private:
+	int numRows, numCols, numTileRows, numTileCols;
+	std::vector<std::vector<char>> tiles;
+};
+
+/*
+* A stack of named layers of the same size, composited bottom to top into
+* one canvas. Cells holding a layer's transparent character let the layers
+* below show through, and hidden layers are left out. The stack remembers
+* which rows changed since the last composite, so editing or hiding one
+* layer only composites the rows that layer touches again.
+*/
+class LayerStack
+{
+public:
+	// An empty stack with no layers, rows or columns
+	LayerStack() { numRows = 0; numCols = 0; }
+	// An empty stack whose layers will have the given number of rows and columns
+	LayerStack(int rows, int cols) { numRows = 0; numCols = 0; resize(rows, cols); }
+
+	int rows() const { return numRows; }
+	int cols() const { return numCols; }
+
+	// Number of layers; layer 0 is the bottom one
+	int count() const { return (int)layers.size(); }
+
+	const std::string& name(int index) const { return layers[index].name; }
+	char transparent(int index) const { return layers[index].transparent; }
+	bool visible(int index) const { return layers[index].visible; }
+	const Canvas& layer(int index) const { return layers[index].canvas; }
+
+	// Removes every layer and sets the size of the layers added after this
+	void resize(int rows, int cols);
+
+	// Adds a blank layer on top of the others; returns its index
+	int addLayer(const std::string& name, char transparent);
+
+	// Returns the index of the layer with the given name, or -1 if there is none
+	int findLayer(const std::string& name) const;
+
+	void removeLayer(int index);
+	void setVisible(int index, bool visible);
+	void setTransparent(int index, char transparent);
+
+	/*
+	* Returns the cells of a layer for drawing with the canvas functions.
+	* Call endEdit once the drawing is done, so the rows which changed in
+	* between are composited again. Only one layer is edited at a time.
+	*/
+	Canvas& beginEdit(int index);
+	void endEdit(int index);
+
+	/*
+	* Composites the rows which changed since the last call into canvas.
+	* canvas must be left alone in between; a canvas of another size is
+	* resized and composited in full. Returns the number of rows composited.
+	*/
+	int composite(Canvas& canvas);
+
+	// Makes the next composite redo every row
+	void invalidate() { dirtyRows.assign(numRows, 1); }
+
+private:
+	struct Layer
+	{
+		std::string name;
+		Canvas canvas;
+		char transparent;
+		bool visible;
+	};
+
+	// Marks the rows where a layer holds anything other than its transparent character
+	void markInked(int index);
+
+	int numRows, numCols;
+	std::vector<Layer> layers;
+	std::vector<char> dirtyRows;
+	Canvas editedLayer;
+};
+
+// Type definition to define the data type for the data items in a linked list.
+// Undo, redo and clip states are only copied and compared, never drawn into,
+// so they are kept sparse and cost memory in proportion to their inked area.
+typedef TiledCanvas ListItemType;
 
 // The node structure for a linked list
 struct Node
 {
 	ListItemType item;
 	Node* next;
+	// hashCanvas of the canvas item holds, taken when the node was made
+	uint64_t hash = 0;
 };
 
 // A list structure containing a linked list and an integer, representing
@@ -64,50 +293,127 @@ struct DrawPoint
 
 /*
 * Opens the specified filename for reading; assumed to be a TXT file.
-* Filename is assumed to be in the form: "SavedFiles\example.txt"
+* Filename is assumed to be in the form: "SavedFiles/example.txt"
 * If the file can be opened for reading, this function loads the
 * file's contents into current canvas, and then returns TRUE.
+* Lines and columns which do not fit in the canvas are ignored.
 * If the file cannot be opened for reading, returns FALSE.
 * If the file cannot be opened, canvas is left unchanged.
+* Lines may end with LF or CRLF, and tabs are expanded to every
+* TABSIZE columns. A filename ending with BINARYEXTENSION is read as a
+* binary canvas file: a header holding the format version, the size and
+* the number of frames, followed by the run-length encoded rows of each
+* frame; later frames may hold only the cells which changed instead.
+* Only the first frame is loaded.
+*/
+bool loadCanvas(Canvas& canvas, char filename[]);
+
+/*
+* Counts of what loadCanvas had to leave out of a file
+*/
+struct LoadStats
+{
+	int lines = 0;				// lines in the file
+	int truncatedLines = 0;		// lines longer than the canvas is wide
+	long long droppedChars = 0;	// characters past the last column
+	int droppedLines = 0;		// lines below the last row
+	int tabs = 0;				// tabs expanded to spaces
+};
+
+/*
+* Works the same way as loadCanvas, and also fills stats with what
+* did not fit into the canvas.
 */
-// Get rid of this:
-void loadCanvas(char canvas[][MAXCOLS]);
-// Use this instead:
-// bool loadCanvas(char canvas[][MAXCOLS], char filename[]);
+bool loadCanvas(Canvas& canvas, char filename[], LoadStats& stats);
 
 /*
 * Opens the specified filename for writing; assumed to be a TXT file.
 * If the file can be opened for writing, this function writes the
 * current canvas contents into the file, and then returns TRUE.
 * If the file cannot be opened for writing, returns FALSE.
+* Spaces at the end of each row are left out, which loadCanvas fills
+* back in. The file is written under a temporary name and renamed into
+* place, so a failed save never leaves a partly written file behind.
+* filename is saved with TEXTEXTENSION added, unless it already ends with
+* TEXTEXTENSION or BINARYEXTENSION; the second saves a binary file.
+*/
+bool saveCanvas(const Canvas& canvas, char filename[]);
+
+/*
+* Works the same way as saveCanvas.
+* fixedWidth: TRUE writes every row at the full canvas width, the way
+* older versions saved files / FALSE trims trailing spaces
+*/
+bool saveCanvas(const Canvas& canvas, char filename[], bool fixedWidth);
+
+/*
+* Writes a canvas into the file at path, as a binary canvas file if the path
+* ends with BINARYEXTENSION and as text otherwise. fixedWidth works the same
+* way as for saveCanvas and only affects text files.
+* Returns TRUE if the file was written, FALSE otherwise.
+*/
+bool writeCanvasFile(const Canvas& canvas, const char* path, bool fixedWidth);
+
+/*
+* Writes count canvases of the same size into one binary canvas file,
+* so a whole clip set takes a single file. A frame which changes little
+* from the one before is stored as a diff of the cells which changed.
+* Returns FALSE if the sizes differ or the file cannot be written.
+*/
+bool writeFramesFile(const Canvas* const frames[], int count, const char* path);
+
+/*
+* Loads every canvas stored in a binary canvas file into frames, each
+* with the size stored in the file. Returns FALSE if the file cannot be
+* read or is damaged, leaving frames empty.
+*/
+bool loadFrames(std::vector<Canvas>& frames, char filename[]);
+
+/*
+* Finds the size of the canvas stored in a file: the dimensions in the
+* header of a binary file, or the number of lines and the widest line
+* of a text file. Returns FALSE if the file cannot be read.
+*/
+bool canvasFileSize(char filename[], int& rows, int& cols);
+
+/*
+* Returns TRUE if filename ends with BINARYEXTENSION
+*/
+bool isBinaryCanvasFile(const char filename[]);
+
+/*
+* Returns TRUE if filename ends with TEXTEXTENSION or BINARYEXTENSION
+*/
+bool hasCanvasExtension(const char filename[]);
+
+/*
+* Writes length bytes of data into the file at path. The data goes into
+* a temporary file first, which then replaces path in one rename.
+* Returns TRUE if the file was written, FALSE otherwise.
 */
-// Get rid of this:
-void saveCanvas(char canvas[][MAXCOLS]);
-// Use this instead:
-// bool saveCanvas(char canvas[][MAXCOLS], char filename[]);
+bool writeFileAtomic(const char* path, const char* data, size_t length);
 
 /*
 * Secondary menu used for choosing the new drawing functions.
 * Menu repeats until the user enters 'M' to return to the main menu.
-* current is a Node representing the main drawing canvas
+* current is the main drawing canvas
 * undoList is a List of nodes, holding all of the undo states
 * redoList is a List of nodes, holding all of the redo states
 * clips is a List of nodes, representing the current animation clip
+* clipboard holds the last rectangle copied or cut, kept between menu calls
 * animate - true: animate / false: no animation
 *   animate will be updated to reflect the menu option chosen by the user
 */
-// Get rid of this:
-void menuTwo(char canvas[][MAXCOLS], char backupCanvas[][MAXCOLS], bool& animate);
-// Use this instead:
-// void menuTwo(Node*& current, List& undoList, List& redoList, List& clips, bool& animate);
+void menuTwo(Canvas& current, List& undoList, List& redoList, List& clips, Canvas& clipboard, bool& animate);
 
 
 //--------------------New Functions---------------------------------------------------------------------
 
 /*
 * Creates and returns a new node, which contains a single blank (initialized) canvas
+* with the given number of rows and columns
 */
-Node* newCanvas();
+Node* newCanvas(int rows, int cols);
 
 /*
 * Creates and returns a new node, which contains a single canvas, where the canvas
@@ -115,6 +421,11 @@ Node* newCanvas();
 */
 Node* newCanvas(Node* oldNode);
 
+/*
+* Creates and returns a new node, which contains a copy of canvas
+*/
+Node* newCanvas(const Canvas& canvas);
+
 /*
 * Adds a node to the front of a linked list
 * listToUpdate is a structure containing the linked list to which the node is to be added
@@ -141,16 +452,32 @@ void deleteList(List& listToDelete);
 * a copy of the current canvas
 * undoList the list to which the new undo state is to be added
 * redoList is the list containing the redo states
-* current is a node reprsenting the current drawing canvas
+* current is the current drawing canvas
+* If the newest undo state already holds the same canvas, no copy is added.
+*/
+void addUndoState(List& undoList, List& redoList, const Canvas& current);
+
+/*
+* Removes the newest undo state if it holds the same canvas as current,
+* so an operation which changed nothing (a cancelled fill, replacing a
+* character which is not there, a move by 0) leaves no undo state behind.
+* Returns TRUE if the undo state was removed.
+*/
+bool dropUnchangedUndoState(List& undoList, const Canvas& current);
+
+/*
+* Adds a copy of the current canvas to the front of the clips list,
+* unless the newest clip already holds the same canvas.
+* Returns TRUE if the clip was added.
 */
-void addUndoState(List& undoList, List& redoList, Node* &current);
+bool addClip(List& clips, const Canvas& current);
 
 /*
 * Undo or Redo operation
-* Adds current node to the front of the redoList, then removes a node  
-* from the front of the undoList and sets this as the current node
+* Adds a copy of the current canvas to the front of the redoList, then removes
+* a node from the front of the undoList and copies its canvas into current
 */
-void restore(List& undoList, List& redoList, Node*& current);
+void restore(List& undoList, List& redoList, Canvas& current);
 
 /*
 * Plays the current animation in the drawing window repeatedly until ESC is held
@@ -174,42 +501,58 @@ void playRecursive(Node* head, int count);
 /*
 * Erases all clips found in the clips list, and then loads a new
 * set of clips into the list, from several saved files.
-* Filename is assumed to be in the form: "SavedFiles\example"
+* Filename is assumed to be in the form: "SavedFiles/example"
 * The function will form filenames like: 
-*   SavedFiles\example-1.txt, SavedFiles\example-2.txt, SavedFiles\example-3.txt, etc.
+*   SavedFiles/example-1.txt, SavedFiles/example-2.txt, SavedFiles/example-3.txt, etc.
 * Each file will be opened and its contents loaded into a new
 * node in the clips list. The item at the front of the list will
 * be the last file (the one with the highest number).
+* Text clips load into canvases of rows x cols, the size of the canvas
+* being edited. A filename such as "SavedFiles/example.rle" loads every
+* clip from that one binary file instead, at the size stored in it.
 * 
 * If the first file can be opened for reading, this function assumes the
 * rest can be also, and loads them into the clips list, then returns TRUE.
 * If the first file cannot be opened for reading, returns FALSE.
 * The current canvas is not affected by this function.
 */
-bool loadClips(List& clips, char filename[]);
+bool loadClips(List& clips, char filename[], int rows, int cols);
 
 /*
 * Writes all of the clips from the clips list into multiple files.
-* Filename is assumed to be in the form: "SavedFiles\example"
+* Filename is assumed to be in the form: "SavedFiles/example"
 * The function will store each clip from the list into a separate file such as:
-*   SavedFiles\example-1.txt, SavedFiles\example-2.txt, SavedFiles\example-3.txt, etc.
+*   SavedFiles/example-1.txt, SavedFiles/example-2.txt, SavedFiles/example-3.txt, etc.
 * The clip at the end of the list will be stored in the first file.
+* A filename ending with ".txt" works the same way; one ending with
+* ".rle" saves every clip into that one binary file.
 * 
 * If the files have been written successfully, this function returns TRUE.
 * If the any file fails to be written, this function returns FALSE.
 */
 bool saveClips(List& clips, char filename[]);
 
+/*
+* Scrolls the current canvas by rowValue rows and colValue columns, spread
+* evenly over the given number of frames, and adds every frame to the clips
+* list. The steps may be fractional (10 columns over 4 frames moves 2.5
+* columns per frame); each frame is rounded to the nearest whole cell.
+* wrap - true: the canvas wraps around its edges / false: uncovered cells are cleared
+* When the function returns, current holds the last frame.
+*/
+void scrollClips(List& clips, Canvas& current, int rowValue, int colValue, int frames, bool wrap);
+
 
 //--------------------Old Functions---------------------------------------------------------------------
 
 /*
 * Allows user to choose a location on the screen moving the cursor around with arrow keys.
 * Continues until the ESC key is pressed, or an ASCII printable character is entered.
+* The cursor is kept within the bounds of canvas.
 * Returns: the character entered by the user
 *   Point pt will be updated to reflect the point chosen by the user
 */
-char getPoint(Point& pt);
+char getPoint(const Canvas& canvas, Point& pt);
 
 /*
 * Recursive function to fill a section of the canvas. Replaces all of adjacent oldCh characters in
@@ -218,8 +561,22 @@ char getPoint(Point& pt);
 * oldCh is the character in the section to be replaced
 * newCh is the character to replace with
 * animate - true: animate / false: no animation
+* Recurses once per cell filled, so a large area can overflow the stack;
+* the editor uses fillScanline instead.
+*/
+void fillRecursive(Canvas& canvas, int row, int col, char oldCh, char newCh, bool animate);
+
+/*
+* Fills the area of the canvas around row, col with newCh: every cell
+* holding the character found at row, col which can be reached from it
+* through cells holding that character. Each run of such cells in a row is
+* found and filled at once, and the runs still to visit are kept on the
+* heap, so no area is too large or too winding to fill.
+* diagonal - true: the area also spreads through the corners of cells
+*   (8 neighbours) / false: only up, down, left and right (4 neighbours)
+* animate - true: each run is shown as it is filled / false: no animation
 */
-void fillRecursive(char canvas[][MAXCOLS], int row, int col, char oldCh, char newCh, bool animate);
+void fillScanline(Canvas& canvas, int row, int col, char newCh, bool diagonal, bool animate);
 
 /*
 * Stores character ch into canvas at location p
@@ -228,15 +585,17 @@ void fillRecursive(char canvas[][MAXCOLS], int row, int col, char oldCh, char ne
 * if animate is true animation is also performed by drawing the character
 * to the screen at the same time it is being stored in the canvas
 */
-void drawHelper(char canvas[][MAXCOLS], Point p, char ch, bool animate);
+void drawHelper(Canvas& canvas, Point p, char ch, bool animate);
 
 /*
 * Draws a line between two points into the canvas.
 * start is the point representing one end of the line
 * end is the point reprsenting the other end of the line
 * animate - true: animate the drawing / false: no animation
+* The line is clipped to the canvas once, and its rows are found with
+* whole-number arithmetic, so only the cells it covers are visited.
 */
-void drawLine(char canvas[][MAXCOLS], DrawPoint start, DrawPoint end, bool animate);
+void drawLine(Canvas& canvas, DrawPoint start, DrawPoint end, bool animate);
 
 /*
 * Draws a box into the canvas, around a central point.
@@ -244,7 +603,7 @@ void drawLine(char canvas[][MAXCOLS], DrawPoint start, DrawPoint end, bool anima
 * height is the height of the box (width is automatically proportionally chosen based on canvas size)
 * animate - true: animate the drawing / false: no animation
 */
-void drawBox(char canvas[][MAXCOLS], Point center, int height, bool  animate);
+void drawBox(Canvas& canvas, Point center, int height, bool  animate);
 
 /*
 * Recursive function to draw a series of nested boxes into the canvas, around a central point.
@@ -252,10 +611,11 @@ void drawBox(char canvas[][MAXCOLS], Point center, int height, bool  animate);
 * height is the height of the largest box (width is automatically proportionally chosen based on canvas size)
 * animate - true: animate the drawing / false: no animation
 */
-void drawBoxesRecursive(char canvas[][MAXCOLS], Point center, int height, bool animate);
+void drawBoxesRecursive(Canvas& canvas, Point center, int height, bool animate);
 
 /*
-* Recursive function to draw a fractal tree into the canvas.
+* Draws a fractal tree into the canvas, branch by branch as a recursive
+* function would, leaving out the branches which cannot reach the canvas.
 * start is the starting point for the tree (the base of the trunk)
 * height is the approximate height of the entire tree
 * startAngle represents the direction in which to draw the trunk where
@@ -264,11 +624,27 @@ void drawBoxesRecursive(char canvas[][MAXCOLS], Point center, int height, bool a
 *     45 means each branch will be at a 45 degree angle from the tree trunk
 * animate - true: animate the drawing / false: no animation
 */
-void treeRecursive(char canvas[][MAXCOLS], DrawPoint start, int height, int startAngle, int branchAngle, bool animate);
+void treeRecursive(Canvas& canvas, DrawPoint start, int height, int startAngle, int branchAngle, bool animate);
+
+/*
+* Draws the same tree as treeRecursive without animation, using several threads
+* (0: one per core). The branches a number of levels up are drawn as separate jobs;
+* each cell write is stamped with its place in the order treeRecursive draws in,
+* and every cell keeps the latest one, so the result does not depend on timing.
+* Small trees are drawn by treeRecursive on the calling thread.
+*/
+void treeParallel(Canvas& canvas, DrawPoint start, int height, int startAngle, int branchAngle, int threads);
+
+/*
+* Finds a rectangle, from top left to bottom right, which holds every cell
+* treeRecursive can draw for the same tree, whatever the canvas size.
+*/
+void treeBounds(DrawPoint start, int height, int startAngle, int branchAngle,
+	double& top, double& left, double& bottom, double& right);
 
 /*
 * Finds the end point of a line, given the line's starting point, length, and angle
-* angle: 0 = east, 90 = south, 180 = west, 270 = north
+* angle: 0 = east, 90 = south, 180 = west, 270 = north; sin and cos come from a table
 * Returns: the end point for the line
 */
 DrawPoint findEndPoint(DrawPoint start, int len, int angle);
@@ -281,39 +657,92 @@ double inline degree2radian(int a) { return (a * 0.017453292519); }
 
 /*
 * Used by the drawLine function to help fill in row gaps in a line
-* col is the column; startRow is the starting row; endRow is the ending row
+* col is the column; startRow is the starting row; endRow is the ending row;
+* the parts off the canvas are left out
 * ch is the character to draw; animate - true: animate the drawing / false: no animation
 */
-void drawLineFillRow(char canvas[][MAXCOLS], int col, int startRow, int endRow, char ch, bool animate);
+void drawLineFillRow(Canvas& canvas, int col, int startRow, int endRow, char ch, bool animate);
 
 /*
 * Initializes canvas to contain all spaces.
 */
-void initCanvas(char canvas[][MAXCOLS]);
+void initCanvas(Canvas& canvas);
 
 /*
 * Displays canvas contents on the screen, with a border
 * around the right and bottom edges.
+* Only the cells which differ from the last canvas displayed are redrawn;
+* the whole canvas is drawn the first time, after invalidateDisplay(),
+* or when the canvas size changes.
+* The cursor is left at the beginning of the line below the border.
 */
-void displayCanvas(char canvas[][MAXCOLS]);
+void displayCanvas(const Canvas& canvas);
+
+/*
+* Makes the next displayCanvas redraw the whole canvas and its border.
+* Call this after the screen has been cleared.
+*/
+void invalidateDisplay();
+
+/*
+* Makes the next displayCanvas redraw the cell at row, col.
+* Call this after writing something other than the canvas contents into that cell.
+*/
+void invalidateDisplay(int row, int col);
 
 /*
 * Allows user to edit the canvas by moving the cursor around and
 * entering characters. Editing continues until the ESC key is pressed.
 */
-void editCanvas(char canvas[][MAXCOLS]);
+void editCanvas(Canvas& canvas);
 
 /*
 * Copies contents of the "from" canvas into the "to" canvas.
+* The "to" canvas takes on the dimensions of the "from" canvas.
+*/
+void copyCanvas(Canvas& to, const Canvas& from);
+
+/*
+* Returns a 64-bit hash of the size and contents of canvas.
+* Canvases with different hashes always differ, so most comparisons
+* never need to read the cells.
+*/
+uint64_t hashCanvas(const Canvas& canvas);
+
+/*
+* Returns TRUE if both canvases have the same size and contents.
+* hashA and hashB are the hashCanvas values of a and b; the cells are
+* only compared when the hashes match.
 */
-void copyCanvas(char to[][MAXCOLS], char from[][MAXCOLS]);
+bool sameCanvas(const Canvas& a, uint64_t hashA, const Canvas& b, uint64_t hashB);
 
 /*
 * Replaces all instances of a character in the canvas.
 * oldCh is the character to be replaced.
 * newCh character is the character to replace with.
 */
-void replace(char canvas[][MAXCOLS], char oldCh, char newCh);
+void replace(Canvas& canvas, char oldCh, char newCh);
+
+/*
+* Sets up map as a translation map which leaves every character unchanged.
+* map must have CHARSETSIZE entries; map[c] is the character which replaces c.
+*/
+void initTranslation(char map[]);
+
+/*
+* Replaces characters in the whole canvas according to a translation map,
+* in a single pass. Every cell holding c becomes map[c]; the replacements
+* are applied all at once, so they do not chain ('a'->'b' and 'b'->'c'
+* turns "ab" into "bc").
+*/
+void translate(Canvas& canvas, const char map[]);
+
+/*
+* Translates count characters in place through a translation map.
+* Uses SSE2 or AVX2 compares when the map changes at most MAXSIMDPAIRS
+* characters, and a table lookup per character otherwise.
+*/
+void translateCells(char* cells, size_t count, const char map[]);
 
 /*
 * Shifts contents of the canvas by a specified number of rows and columns.
@@ -321,19 +750,597 @@ void replace(char canvas[][MAXCOLS], char oldCh, char newCh);
 *    positive numbers shift downward; negative numbers shift upward
 * colValue is the number of rows by which to shift
 *    positive numbers shift right; negative numbers shift left
+* wrap - true: whatever is shifted off one edge comes back at the opposite
+*    edge (toroidal scroll) / false: it is lost, and the uncovered cells are cleared
+* The canvas is shifted in place, without a temporary canvas.
 */
-void moveCanvas(char canvas[][MAXCOLS], int rowValue, int colValue);
+void moveCanvas(Canvas& canvas, int rowValue, int colValue);
+void moveCanvas(Canvas& canvas, int rowValue, int colValue, bool wrap);
 
 /*
 * Clears a line on the output screen, then resets the cursor back to the
 * beginning of this line.
 * lineNum is the line number on the output screen to clear
-* numOfChars is the number of characters to clear on this line
+* The whole line is cleared, however wide the screen is.
 */
-void clearLine(int lineNum, int numOfChars);
+void clearLine(int lineNum);
 
 /*
 * Moves the cursor in the output window to a specified row and column.
 * The next output produced by the program will begin at this position.
 */
-void gotoxy(short row, short col);
\ No newline at end of file
+void gotoxy(short row, short col);
+
+
+//--------------------Screen Output---------------------------------------------------------------------
+
+// Longest text framePrintf can add in one call
+const int FRAMELINESIZE = 512;
+
+/*
+* Totals of the output sent to the screen, used to measure rendering cost
+*/
+struct FrameStats
+{
+	long long bytes = 0;	// bytes sent to the screen
+	long long writes = 0;	// write calls made
+	long long frames = 0;	// frames sent
+};
+
+/*
+* All screen output (displayCanvas, gotoxy, clearLine and menu text) is
+* collected into a frame and sent to the screen with one write call.
+* beginFrame starts a frame and endFrame sends it. Frames can be nested, and
+* only the outermost endFrame sends the output. Output added outside any
+* frame is sent right away.
+* Text written with cout or printf is flushed before each frame is sent,
+* so the two can be mixed.
+*/
+void beginFrame();
+void endFrame();
+
+/*
+* Adds text to the current frame.
+*/
+void frameWrite(const char* text, size_t length);
+void frameWrite(const char* text);
+
+/*
+* Adds printf-style formatted text to the current frame.
+* At most FRAMELINESIZE - 1 characters are added.
+*/
+void framePrintf(const char* format, ...);
+
+/*
+* Returns the totals of the output sent since the program started or
+* since resetFrameStats was called.
+*/
+FrameStats frameStats();
+
+/*
+* Sets the output totals back to zero.
+*/
+void resetFrameStats();
+
+/*
+* true: frames are sent to the screen (default)
+* false: frames are only counted, for benchmarks
+*/
+void setFrameOutput(bool enabled);
+
+
+//--------------------Keyboard And Timing---------------------------------------------------------------
+
+/*
+* The terminal functions have two backends, chosen when compiling:
+* the Windows console (conio.h and windows.h), and POSIX terminals
+* (termios raw mode and ANSI escape sequences).
+*/
+
+/*
+* Reads a single key without waiting for ENTER and without echoing it.
+* Works like _getch: an arrow key is returned as SPECIAL, followed by
+* LEFTARROW, RIGHTARROW, UPARROW or DOWNARROW on the next call.
+* Other special keys return '\0' followed by a code which can be ignored.
+*/
+char getKey();
+
+/*
+* Switches the keyboard to single-key input for a series of getKey calls,
+* so keys typed between the calls are not echoed. Calls may be nested.
+*/
+void beginKeyInput();
+void endKeyInput();
+
+/*
+* Returns true if ESC is being held (Windows) or has been pressed since
+* the last call (POSIX terminals). Does not wait for a key.
+*/
+bool escapePressed();
+
+/*
+* Waits for the given number of milliseconds.
+*/
+void pauseFor(int milliseconds);
+
+/*
+* Clears the whole screen and moves the cursor to the top left corner.
+* The next displayCanvas redraws the whole canvas.
+*/
+void clearScreen();
+
+/*
+* Shows message and waits until any key is pressed.
+*/
+void waitForKey(const char* message);
+
+
+//--------------------Operation Timing------------------------------------------------------------------
+
+/*
+* Editor operations whose latency is measured, so a slow session shows
+* whether the time goes to the screen, to files or to drawing
+*/
+enum TimedOperation
+{
+	TIMEDISPLAY, TIMELOAD, TIMESAVE, TIMEMOVE, TIMETRANSFORM, TIMEREPLACE, TIMECLEAR, TIMEFILL, TIMELINE, TIMEBOX, TIMEBOXES,
+	TIMETREE, TIMECOPY, TIMEPASTE, TIMESTAMP, TIMEUNDO, TIMEREDO, TIMECLIP, TIMEPLAYFRAME, TIMEDOPERATIONS
+};
+
+// Each power of two of a latency histogram is split into 2^LATENCYSUBBITS
+// buckets, so a reported latency is at most 1/16 above the real one
+const int LATENCYSUBBITS = 4;
+
+/*
+* Measures the time from start (or construction) until stop or the end of
+* its scope, and adds it to the latency histogram of an operation. A timer
+* declared before a menu's switch can be started by whichever case runs, once
+* its prompts are answered. Timing costs two clock reads and a few counter
+* updates, so the timers stay in the editor.
+*/
+class ScopedTimer
+{
+public:
+	// A timer which has not started yet
+	ScopedTimer() { running = false; timedOperation = TIMEDISPLAY; startTime = 0; }
+	// A timer which starts right away
+	ScopedTimer(TimedOperation operation) { start(operation); }
+	~ScopedTimer() { stop(); }
+
+	// Starts timing operation, dropping any measurement not stopped yet
+	void start(TimedOperation operation);
+
+	// Records the time since start; does nothing if the timer is not running
+	void stop();
+
+private:
+	bool running;
+	TimedOperation timedOperation;
+	long long startTime;
+};
+
+/*
+* Adds one measurement of nanos nanoseconds to the histogram of an operation.
+* Safe to call from several threads at once.
+*/
+void recordLatency(TimedOperation operation, unsigned long long nanos);
+
+/*
+* Empties every latency histogram.
+*/
+void resetLatencies();
+
+/*
+* Sets report to a table of the latencies measured so far: for each
+* operation which ran, the count, mean, 50th, 90th, 99th and 99.9th
+* percentiles and the largest value, in microseconds.
+*/
+void latencyReport(std::string& report);
+
+/*
+* Writes the latencyReport table into the file at path.
+* Returns TRUE if the file was written, FALSE otherwise.
+*/
+bool saveLatencyReport(const char* path);
+
+
+//--------------------Work Pool-------------------------------------------------------------------------
+
+/*
+* Calls work(job) once for every job from 0 to jobs - 1, spread over the
+* given number of threads (0: one per core). Each thread starts with an
+* equal share of the jobs; a thread which runs out takes half of what
+* is left to another thread, so slow jobs do not hold up the rest.
+* Returns once every job has run. work must be safe to call from
+* several threads at once.
+*/
+void runParallel(size_t jobs, int threads, const std::function<void(size_t job)>& work);
+
+
+//--------------------Canvas Regions--------------------------------------------------------------------
+
+/*
+* Copies length cells over out, except those holding the transparent
+* character, which leave the cell in out as it was
+*/
+void blendCells(char* out, const char* cells, int length, char transparent);
+
+/*
+* Copies the rectangle with corners a and b out of canvas into clipboard,
+* which takes on the size of the rectangle. The corners may be given in
+* either order and both are included; the parts of the rectangle off the
+* canvas are left out. Returns FALSE, leaving clipboard empty, if the
+* rectangle misses the canvas.
+*/
+bool copyRegion(Canvas& clipboard, const Canvas& canvas, Point a, Point b);
+
+/*
+* Works the same way as copyRegion, and then fills the rectangle with spaces.
+*/
+bool cutRegion(Canvas& clipboard, Canvas& canvas, Point a, Point b);
+
+/*
+* Draws clipboard into canvas with its top left cell at topLeft, one row
+* at a time. The clipboard may hang over any edge of the canvas; what falls
+* off it is left out.
+* opaque - true: spaces in the clipboard are pasted too / false: they are
+*   transparent, so the canvas shows through them
+*/
+void pasteCanvas(Canvas& canvas, const Canvas& clipboard, Point topLeft, bool opaque);
+
+/*
+* Loads a .txt or .rle canvas file at the size stored in it and pastes it
+* into canvas at topLeft with transparent spaces, so art from SavedFiles
+* can be used as a sprite. Returns FALSE, leaving canvas unchanged, if
+* the file cannot be read.
+*/
+bool stampCanvas(Canvas& canvas, char filename[], Point topLeft);
+
+
+//--------------------Canvas Transforms-----------------------------------------------------------------
+
+/*
+* Ways transformCanvas can move the cells of a canvas. The rotations are
+* clockwise; TRANSPOSE swaps rows and columns, mirroring across the
+* diagonal from the top left corner.
+*/
+enum CanvasTransform
+{
+	MIRRORLEFTRIGHT, MIRRORTOPBOTTOM, ROTATE90, ROTATE180, ROTATE270, TRANSPOSE
+};
+
+/*
+* Rotates, mirrors or transposes canvas. Mirrors and ROTATE180 work in
+* place; the other transforms copy the cells in small squares, so the
+* source and the result both stay in the cache on large canvases.
+* resize - true: ROTATE90, ROTATE270 and TRANSPOSE swap the number of rows
+*   and columns / false: the canvas keeps its size, and the top left of the
+*   result is kept, as much as fits, with any uncovered cells cleared
+*/
+void transformCanvas(Canvas& canvas, CanvasTransform transform, bool resize);
+
+
+//--------------------Canvas Diffs----------------------------------------------------------------------
+
+/*
+* One run of changed cells: length cells of a row, starting at column col
+*/
+struct CellRun
+{
+	int row;
+	int col;
+	int length;
+};
+
+/*
+* What changed between two canvases of the same size. The runs are in
+* row-major order and never cross the end of a row; before and after hold
+* the cells of every run back to back, as they were and as they became.
+*/
+struct CanvasDiff
+{
+	int rows = 0;
+	int cols = 0;
+	std::vector<CellRun> runs;
+	std::vector<char> before;
+	std::vector<char> after;
+};
+
+/*
+* Finds every cell which differs between from and to. Changed cells less
+* than MINDIFFGAP apart share one run, since a run costs more than a few
+* unchanged cells. Returns FALSE, leaving diff empty, if the sizes differ.
+*/
+bool diffCanvas(const Canvas& from, const Canvas& to, CanvasDiff& diff);
+
+/*
+* Writes the "after" cells of diff into canvas, turning the canvas it
+* was computed from into the other one. Returns FALSE, leaving canvas
+* unchanged, if canvas is not the size of the diff.
+*/
+bool applyDiff(Canvas& canvas, const CanvasDiff& diff);
+
+/*
+* Turns diff around, so applying it undoes the change instead
+*/
+void invertDiff(CanvasDiff& diff);
+
+
+//--------------------Image Conversion------------------------------------------------------------------
+
+// Characters imageToCanvas uses when no ramp is given, from black to white
+const char DEFAULTRAMP[] = " .:-=+*#%@";
+
+/*
+* A grayscale image: width x height bytes of luminance, row-major,
+* where 0 is black and 255 is white
+*/
+struct Image
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> pixels;
+};
+
+/*
+* Loads a PGM or PPM image file, in either the plain or the raw form.
+* Color pixels are turned into luminance. Returns FALSE if the file
+* cannot be read or is not such an image, leaving image empty.
+*/
+bool loadImage(Image& image, const char* filename);
+
+/*
+* Returns TRUE if filename ends with ".pgm" or ".ppm"
+*/
+bool isImageFile(const char filename[]);
+
+/*
+* Draws image into canvas, scaled to the size the canvas already has.
+* Each cell gets the average luminance of the area of the image it covers,
+* mapped onto ramp: the first character stands for black and the last one
+* for white. A NULL or empty ramp uses DEFAULTRAMP.
+* The rows of the canvas are converted on the given number of threads
+* (0: one per core).
+*/
+void imageToCanvas(Canvas& canvas, const Image& image, const char ramp[], int threads);
+
+/*
+* Loads an image file with loadImage and draws it into canvas with
+* imageToCanvas. Returns FALSE if the image cannot be read, leaving
+* canvas unchanged.
+*/
+bool loadImageCanvas(Canvas& canvas, const char* filename, const char ramp[], int threads);
+
+
+//--------------------Batch Scripts---------------------------------------------------------------------
+
+/*
+* Runs a script of canvas commands without the screen or keyboard, so art
+* can be generated without a terminal. The script starts with a blank
+* MAXROWS x MAXCOLS canvas and no clips. Each line holds one command;
+* words in quotes may contain spaces, and '#' starts a comment.
+*
+*   canvas ROWS COLS           start over with a blank canvas of this size
+*   clear                      blank the canvas
+*   load PATH                  load a .txt or .rle file into the canvas
+*   image PATH [RAMP]          draw a .pgm or .ppm image scaled to the canvas
+*   save PATH [fixed]          save the canvas; fixed keeps full-width rows
+*   move ROWS COLS [wrap]      move the canvas, wrapping around the edges
+*   replace OLD NEW            replace each character of OLD with the one in NEW
+*   line ROW COL ROW COL       draw a line between two points
+*   box ROW COL SIZE           draw a box around a center point
+*   boxes ROW COL SIZE         draw nested boxes around a center point
+*   tree ROW COL HEIGHT ANGLE  draw a tree growing up from a point
+*   fill ROW COL CH [diagonal] fill the area around a point with CH, spreading
+*                              through corners too with diagonal
+*   text ROW COL TEXT          write TEXT from a point to the right
+*   clip                       add a copy of the canvas to the clips
+*   loadclips PATH             load PATH-1.txt, PATH-2.txt, ... or one .rle file
+*   saveclips PATH             save the clips the same way
+*   layer NAME [CH]            draw into layer NAME from now on, adding it on top
+*                              if it is new; CH is its transparent character
+*   hide NAME / show NAME      leave a layer out of the canvas, or put it back
+*   copy ROW COL ROW COL       copy the rectangle between two corners
+*   cut ROW COL ROW COL        copy the rectangle, then blank it
+*   paste ROW COL [opaque]     paste what was copied with its top left at a point;
+*                              spaces let the canvas show through unless opaque
+*   stamp PATH ROW COL         paste a .txt or .rle file the same way
+*   rotate ANGLE [clip]        rotate by 90, 180 or 270 degrees clockwise; the
+*                              canvas swaps its sides unless clip is given
+*   mirror DIRECTION           mirror leftright or topbottom
+*   transpose [clip]           swap rows and columns, resizing like rotate
+*   savelist PATH              save the lines, boxes, trees, fills and text drawn
+*                              since the canvas was started over or cleared as
+*                              a display list
+*   drawlist PATH              draw a saved display list, scaled to the canvas
+*
+* Before the first layer command, drawing goes straight into the canvas,
+* which then becomes the bottom layer, "base". The canvas command removes
+* all layers again. Layers keep their size, so rotating one always clips.
+* The display list holds only the drawing commands, so what load, paste
+* and the other commands did is not in it; it starts over when the canvas
+* being drawn into changes size.
+*
+* Paths are used as given. Scripts keep no shared state, so several may
+* run at the same time on different threads.
+* Returns FALSE and sets error to the line number and reason if a command fails.
+*/
+bool runScript(std::istream& script, std::string& error);
+
+/*
+* Runs the script in a file. Works the same way as runScript for a stream.
+*/
+bool runScript(const char* filename, std::string& error);
+
+
+//--------------------Display Lists---------------------------------------------------------------------
+
+/*
+* Kinds of drawing a display list keeps, one per drawing command of scripts
+*/
+enum PrimitiveKind
+{
+	PRIMITIVELINE, PRIMITIVEBOX, PRIMITIVEBOXES, PRIMITIVETREE, PRIMITIVEFILL, PRIMITIVETEXT
+};
+
+/*
+* One drawing kept in a display list, in the cells of the canvas size the
+* list was made for.
+*   line: from a to b
+*   box, boxes: around a, size rows high, as drawBox and drawBoxesRecursive
+*   tree: growing north from a, size rows high, angle degrees between branches
+*   fill: from a with ch, spreading through corners too if diagonal
+*   text: text written from a to the right, spaces included
+*/
+struct DrawPrimitive
+{
+	PrimitiveKind kind = PRIMITIVELINE;
+	Point a, b;
+	int size = 0;
+	int angle = 0;
+	char ch = ' ';
+	bool diagonal = false;
+	std::string text;
+};
+
+/*
+* A list of drawings kept after they are drawn, so the whole drawing, or
+* one rectangle of it, can be drawn again onto a canvas of any size. Points
+* and heights are scaled from the list's size to the canvas, and each
+* primitive which cannot reach the cells being drawn is left out before
+* any of its cells are visited.
+*/
+class DisplayList
+{
+public:
+	// An empty list for a canvas with no rows or columns
+	DisplayList() { numRows = 0; numCols = 0; }
+	// An empty list for a canvas of the given size
+	DisplayList(int rows, int cols) { numRows = rows; numCols = cols; }
+
+	// Size of the canvas the points and heights of the primitives are given for
+	int rows() const { return numRows; }
+	int cols() const { return numCols; }
+
+	// Number of primitives; primitive 0 is drawn first
+	int count() const { return (int)primitives.size(); }
+	const DrawPrimitive& operator[](int index) const { return primitives[index]; }
+
+	// Removes every primitive and sets the canvas size of those added after this
+	void resize(int rows, int cols);
+
+	// Adds a primitive drawn after the others; returns its index
+	int add(const DrawPrimitive& primitive);
+
+	void replace(int index, const DrawPrimitive& primitive);
+	void remove(int index);
+
+	/*
+	* Finds the rectangle of canvas which a primitive, scaled to the canvas
+	* size, can draw into. A fill may reach any cell. Returns FALSE if the
+	* primitive cannot draw into the canvas at all.
+	*/
+	bool bounds(int index, const Canvas& canvas, int& top, int& left, int& bottom, int& right) const;
+
+	/*
+	* Draws every primitive in order over what canvas holds, without animation.
+	*/
+	void rasterize(Canvas& canvas) const;
+
+	/*
+	* Draws the rectangle with corners a and b again after primitives reaching
+	* into it were changed. canvas must hold the list drawn over a blank canvas
+	* everywhere else; the rectangle is blanked and the primitives which can
+	* reach it are drawn in order, leaving the cells around it as they were.
+	* A fill spreads by what the whole canvas holds, so a list with a fill is
+	* drawn again in full.
+	*/
+	void rasterizeRegion(Canvas& canvas, Point a, Point b) const;
+
+private:
+	int numRows, numCols;
+	std::vector<DrawPrimitive> primitives;
+};
+
+/*
+* Draws one primitive into canvas at the size it was made for, without animation.
+*/
+void drawPrimitive(Canvas& canvas, const DrawPrimitive& primitive);
+
+/*
+* Saves a display list as a script: a canvas command with the list's size,
+* then one line, box, boxes, tree, fill or text command per primitive, so
+* it can also be run by runScript. Returns FALSE if the file cannot be
+* written, or a text holds both kinds of quote.
+*/
+bool saveDisplayList(const DisplayList& list, const char* filename);
+
+/*
+* Loads a display list saved by saveDisplayList, or any script made only
+* of those commands. Without a canvas command the points are used as given.
+* Returns FALSE and sets error to the line number and reason if a line
+* cannot be read.
+*/
+bool loadDisplayList(DisplayList& list, const char* filename, std::string& error);
+
+
+//--------------------Sparse Canvas Functions-----------------------------------------------------------
+
+/*
+* Initializes a tiled canvas to contain all spaces, freeing all of its tiles.
+*/
+void initCanvas(TiledCanvas& canvas);
+
+/*
+* Copies contents of the "from" canvas into the "to" canvas.
+* The "to" canvas takes on the dimensions of the "from" canvas.
+* Only tiles holding something other than spaces are stored in a TiledCanvas.
+*/
+void copyCanvas(TiledCanvas& to, const TiledCanvas& from);
+void copyCanvas(TiledCanvas& to, const Canvas& from);
+void copyCanvas(Canvas& to, const TiledCanvas& from);
+
+/*
+* Stores character ch into a tiled canvas at location p.
+* Works the same way as drawHelper for a Canvas.
+*/
+void drawHelper(TiledCanvas& canvas, Point p, char ch, bool animate);
+
+/*
+* Replaces all instances of a character in a tiled canvas.
+* Only allocated tiles are visited unless oldCh is a space.
+* Tiles left containing only spaces are freed.
+*/
+void replace(TiledCanvas& canvas, char oldCh, char newCh);
+
+/*
+* Translates a tiled canvas through a translation map, like translate
+* for a Canvas. Only allocated tiles are visited unless the map changes spaces.
+*/
+void translate(TiledCanvas& canvas, const char map[]);
+
+/*
+* Shifts contents of a tiled canvas by a specified number of rows and columns.
+* Works the same way as moveCanvas for a Canvas, but only visits allocated tiles.
+*/
+void moveCanvas(TiledCanvas& canvas, int rowValue, int colValue);
+
+/*
+* Writes a tiled canvas into a TXT file in the same format as saveCanvas
+* for a Canvas. Returns TRUE if the file was written, FALSE otherwise.
+*/
+bool saveCanvas(const TiledCanvas& canvas, char filename[]);
+bool saveCanvas(const TiledCanvas& canvas, char filename[], bool fixedWidth);
+
+/*
+* Writes a tiled canvas into the file at path, the same way as
+* writeCanvasFile for a Canvas.
+*/
+bool writeCanvasFile(const TiledCanvas& canvas, const char* path, bool fixedWidth);
+
+/*
+* Returns TRUE if a tiled canvas and a canvas have the same size and contents.
+* hashA and hashB are the hashCanvas values of the canvases the two hold;
+* the cells are only compared when the hashes match.
+*/
+bool sameCanvas(const TiledCanvas& a, uint64_t hashA, const Canvas& b, uint64_t hashB);
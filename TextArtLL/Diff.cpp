@@ -0,0 +1,141 @@
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include "Definitions.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIFF_SSE2
+#endif
+
+using namespace std;
+
+
+// Returns the first position from start on where a and b differ, or end if they do not
+static int findDifference(const char* a, const char* b, int start, int end)
+{
+	int x = start;
+#ifdef DIFF_SSE2
+	// Skip 16 equal cells at a time
+	for (; x + 16 <= end; x += 16)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + x));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+		int same = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+		if (same != 0xFFFF)
+		{
+			int offset = 0;
+			while (same & (1 << offset))
+				offset++;
+			return x + offset;
+		}
+	}
+#endif
+	while (x < end && a[x] == b[x])
+		x++;
+	return x;
+}
+
+
+// Returns the first position from start on where a and b are equal, or end if they never are
+static int findSame(const char* a, const char* b, int start, int end)
+{
+	int x = start;
+#ifdef DIFF_SSE2
+	// Skip 16 changed cells at a time
+	for (; x + 16 <= end; x += 16)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + x));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+		int same = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+		if (same != 0)
+		{
+			int offset = 0;
+			while (!(same & (1 << offset)))
+				offset++;
+			return x + offset;
+		}
+	}
+#endif
+	while (x < end && a[x] != b[x])
+		x++;
+	return x;
+}
+
+
+/**
+* Finds the runs of cells which differ between two canvases of the same size.
+*
+* @param[in] from Canvas before the change
+* @param[in] to Canvas after the change
+* @param[out] diff Runs of changed cells, with their contents in both canvases
+*/
+bool diffCanvas(const Canvas& from, const Canvas& to, CanvasDiff& diff)
+{
+	diff.rows = from.rows();
+	diff.cols = from.cols();
+	diff.runs.clear();
+	diff.before.clear();
+	diff.after.clear();
+
+	if (from.rows() != to.rows() || from.cols() != to.cols())
+		return false;
+
+	for (int row = 0; row < from.rows(); row++)
+	{
+		const char* a = from[row];
+		const char* b = to[row];
+		int col = findDifference(a, b, 0, from.cols());
+
+		while (col < from.cols())
+		{
+			// Short stretches of unchanged cells cost less than starting a new run
+			int end = findSame(a, b, col, from.cols());
+			int next = findDifference(a, b, end, from.cols());
+			while (next < from.cols() && next - end < MINDIFFGAP)
+			{
+				end = findSame(a, b, next, from.cols());
+				next = findDifference(a, b, end, from.cols());
+			}
+
+			CellRun run;
+			run.row = row;
+			run.col = col;
+			run.length = end - col;
+			diff.runs.push_back(run);
+			diff.before.insert(diff.before.end(), a + col, a + end);
+			diff.after.insert(diff.after.end(), b + col, b + end);
+			col = next;
+		}
+	}
+	return true;
+}
+
+
+/**
+* Writes the changed cells of a diff into a canvas.
+*
+* @param[in, out] canvas Canvas the diff was computed from
+* @param[in] diff Changes to make
+*/
+bool applyDiff(Canvas& canvas, const CanvasDiff& diff)
+{
+	if (canvas.rows() != diff.rows || canvas.cols() != diff.cols)
+		return false;
+
+	const char* cells = diff.after.data();
+	for (size_t i = 0; i < diff.runs.size(); i++)
+	{
+		const CellRun& run = diff.runs[i];
+		memcpy(canvas[run.row] + run.col, cells, run.length);
+		cells += run.length;
+	}
+	return true;
+}
+
+
+void invertDiff(CanvasDiff& diff)
+{
+	// Every run covers the same cells both ways
+	diff.before.swap(diff.after);
+}
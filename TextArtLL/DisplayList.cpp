@@ -0,0 +1,274 @@
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "Definitions.h"
+using namespace std;
+
+
+// Maps a row or column of a side of from cells onto a side of to cells,
+// keeping the first and the last cell where they are
+static double scaleCoordinate(int value, int from, int to)
+{
+	if (from <= 1 || to <= 1 || from == to)
+		return value;
+	return value * (to - 1) / (double)(from - 1);
+}
+
+
+// Scales a height given for a canvas of from rows to one of to rows
+static int scaleHeight(int height, int from, int to)
+{
+	if (from < 1 || to < 1 || from == to)
+		return height;
+	return (int)round(height * to / (double)from);
+}
+
+
+// Where a primitive of a list made for rows x cols lands on canvas: its
+// points and its height, scaled to the size of canvas
+static void placePrimitive(const DrawPrimitive& primitive, int rows, int cols, const Canvas& canvas,
+	DrawPoint& a, DrawPoint& b, int& size)
+{
+	a.row = scaleCoordinate(primitive.a.row, rows, canvas.rows());
+	a.col = scaleCoordinate(primitive.a.col, cols, canvas.cols());
+	b.row = scaleCoordinate(primitive.b.row, rows, canvas.rows());
+	b.col = scaleCoordinate(primitive.b.col, cols, canvas.cols());
+	size = scaleHeight(primitive.size, rows, canvas.rows());
+}
+
+
+// Draws a primitive placed by placePrimitive
+static void drawPlaced(Canvas& canvas, const DrawPrimitive& primitive, DrawPoint a, DrawPoint b, int size)
+{
+	Point at(a);
+	switch (primitive.kind)
+	{
+	case PRIMITIVELINE:
+		drawLine(canvas, a, b, false);
+		break;
+	case PRIMITIVEBOX:
+		drawBox(canvas, at, size, false);
+		break;
+	case PRIMITIVEBOXES:
+		drawBoxesRecursive(canvas, at, size, false);
+		break;
+	case PRIMITIVETREE:
+		treeRecursive(canvas, a, size, 270, primitive.angle, false);
+		break;
+	case PRIMITIVEFILL:
+		fillScanline(canvas, at.row, at.col, primitive.ch, primitive.diagonal, false);
+		break;
+	case PRIMITIVETEXT:
+		if (at.row >= 0 && at.row < canvas.rows())
+		{
+			// Only the characters landing on the canvas are written
+			int first = max(0, -at.col);
+			int last = min((int)primitive.text.size(), canvas.cols() - at.col);
+			if (first < last)
+				memcpy(canvas[at.row] + (at.col + first), primitive.text.data() + first, last - first);
+		}
+		break;
+	}
+}
+
+
+// Finds the rectangle a placed primitive can draw into, before clipping it to
+// the canvas; returns false if the primitive draws nothing
+static bool placedBounds(const Canvas& canvas, const DrawPrimitive& primitive, DrawPoint a, DrawPoint b, int size,
+	double& top, double& left, double& bottom, double& right)
+{
+	Point at(a);
+	if (primitive.kind == PRIMITIVELINE)
+	{
+		// drawLine runs a slanted line on to the rows at the whole columns
+		// around its ends, up to half a column past them, plus one for rounding
+		double rows = fabs(b.row - a.row);
+		double cols = fabs(b.col - a.col);
+		double spill = cols > 0 ? rows / cols / 2 + 1 : 1;
+		top = min(a.row, b.row) - spill;
+		bottom = max(a.row, b.row) + spill;
+		left = min(a.col, b.col) - 1;
+		right = max(a.col, b.col) + 1;
+	}
+	else if (primitive.kind == PRIMITIVEBOX || primitive.kind == PRIMITIVEBOXES)
+	{
+		// The outer box, sized the way drawBox sizes it
+		if (primitive.kind == PRIMITIVEBOXES && size <= 1)
+			return false;
+		int sizeHalf = size / 2;
+		int ratio = (int)round(canvas.cols() / (double)canvas.rows() * sizeHalf);
+		top = at.row - abs(sizeHalf);
+		bottom = at.row + abs(sizeHalf);
+		left = at.col - abs(ratio);
+		right = at.col + abs(ratio);
+	}
+	else if (primitive.kind == PRIMITIVETREE)
+	{
+		if (size < 3)
+			return false;
+		treeBounds(a, size, 270, primitive.angle, top, left, bottom, right);
+	}
+	else if (primitive.kind == PRIMITIVEFILL)
+	{
+		top = 0;
+		left = 0;
+		bottom = canvas.rows() - 1;
+		right = canvas.cols() - 1;
+	}
+	else
+	{
+		if (primitive.text.empty())
+			return false;
+		top = bottom = at.row;
+		left = at.col;
+		right = at.col + (double)primitive.text.size() - 1;
+	}
+	return true;
+}
+
+
+void DisplayList::resize(int rows, int cols)
+{
+	primitives.clear();
+	numRows = rows;
+	numCols = cols;
+}
+
+
+int DisplayList::add(const DrawPrimitive& primitive)
+{
+	primitives.push_back(primitive);
+	return (int)primitives.size() - 1;
+}
+
+
+void DisplayList::replace(int index, const DrawPrimitive& primitive)
+{
+	primitives[index] = primitive;
+}
+
+
+void DisplayList::remove(int index)
+{
+	primitives.erase(primitives.begin() + index);
+}
+
+
+/**
+* Finds the cells of the canvas a primitive can draw into.
+*
+* @param index Primitive to look at
+* @param[in] canvas Canvas the primitive is scaled to
+* @param[out] top, left, bottom, right Rectangle on the canvas, all included
+*/
+bool DisplayList::bounds(int index, const Canvas& canvas, int& top, int& left, int& bottom, int& right) const
+{
+	DrawPoint a, b;
+	int size;
+	double up, west, down, east;
+	placePrimitive(primitives[index], numRows, numCols, canvas, a, b, size);
+	if (!placedBounds(canvas, primitives[index], a, b, size, up, west, down, east))
+		return false;
+
+	// Clip while still in doubles, so a far away primitive cannot overflow an int
+	up = max(floor(up), 0.0);
+	west = max(floor(west), 0.0);
+	down = min(ceil(down), canvas.rows() - 1.0);
+	east = min(ceil(east), canvas.cols() - 1.0);
+	if (up > down || west > east)
+		return false;
+
+	top = (int)up;
+	left = (int)west;
+	bottom = (int)down;
+	right = (int)east;
+	return true;
+}
+
+
+/**
+* Draws the whole list, scaled to the canvas.
+*
+* @param[in, out] canvas Canvas to draw over
+*/
+void DisplayList::rasterize(Canvas& canvas) const
+{
+	int top, left, bottom, right;
+	for (int i = 0; i < count(); i++)
+	{
+		if (!bounds(i, canvas, top, left, bottom, right))
+			continue;
+
+		DrawPoint a, b;
+		int size;
+		placePrimitive(primitives[i], numRows, numCols, canvas, a, b, size);
+		drawPlaced(canvas, primitives[i], a, b, size);
+	}
+}
+
+
+/**
+* Draws one rectangle of the list again.
+*
+* @param[in, out] canvas Canvas holding the list as drawn before the change
+* @param a One corner of the rectangle
+* @param b The opposite corner
+*/
+void DisplayList::rasterizeRegion(Canvas& canvas, Point a, Point b) const
+{
+	for (int i = 0; i < count(); i++)
+	{
+		if (primitives[i].kind == PRIMITIVEFILL)
+		{
+			initCanvas(canvas);
+			rasterize(canvas);
+			return;
+		}
+	}
+
+	int top = max(min(a.row, b.row), 0);
+	int left = max(min(a.col, b.col), 0);
+	int bottom = min(max(a.row, b.row), canvas.rows() - 1);
+	int right = min(max(a.col, b.col), canvas.cols() - 1);
+	if (top > bottom || left > right)
+		return;
+
+	// The primitives reaching the rectangle also draw outside of it, over
+	// cells later primitives may have covered, so they are drawn into a
+	// canvas of the same size and only the rectangle is copied back. Reused
+	// between calls, so redrawing the same canvas again allocates nothing.
+	thread_local Canvas scratch;
+	if (scratch.rows() != canvas.rows() || scratch.cols() != canvas.cols())
+		scratch.resize(canvas.rows(), canvas.cols());
+	int width = right - left + 1;
+	for (int row = top; row <= bottom; row++)
+		memset(scratch[row] + left, ' ', width);
+
+	int up, west, down, east;
+	for (int i = 0; i < count(); i++)
+	{
+		if (!bounds(i, canvas, up, west, down, east) || down < top || up > bottom || east < left || west > right)
+			continue;
+
+		DrawPoint from, to;
+		int size;
+		placePrimitive(primitives[i], numRows, numCols, canvas, from, to, size);
+		drawPlaced(scratch, primitives[i], from, to, size);
+	}
+
+	for (int row = top; row <= bottom; row++)
+		memcpy(canvas[row] + left, scratch[row] + left, width);
+}
+
+
+/**
+* Draws one primitive at the size it was made for.
+*
+* @param[in, out] canvas Canvas to draw into
+* @param[in] primitive What to draw
+*/
+void drawPrimitive(Canvas& canvas, const DrawPrimitive& primitive)
+{
+	drawPlaced(canvas, primitive, DrawPoint(primitive.a), DrawPoint(primitive.b), primitive.size);
+}
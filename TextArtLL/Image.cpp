@@ -0,0 +1,333 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include "Definitions.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_SSE2
+#endif
+
+using namespace std;
+
+
+// Reads the next number of a PGM/PPM header, skipping whitespace and '#' comments
+static bool readHeaderValue(const vector<char>& data, size_t& pos, int& value)
+{
+	while (pos < data.size())
+	{
+		if (data[pos] == '#')
+		{
+			while (pos < data.size() && data[pos] != '\n')
+				pos++;
+		}
+		else if (isspace((unsigned char)data[pos]))
+		{
+			pos++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (pos >= data.size() || !isdigit((unsigned char)data[pos]))
+		return false;
+
+	long long number = 0;
+	while (pos < data.size() && isdigit((unsigned char)data[pos]) && number <= 0xFFFFFF)
+	{
+		number = number * 10 + (data[pos] - '0');
+		pos++;
+	}
+	if (number > 0xFFFFFF)
+		return false;
+
+	value = (int)number;
+	return true;
+}
+
+
+// Reads one sample of the pixel data, scaled from 0..maxValue to 0..255
+static bool readSample(const vector<char>& data, size_t& pos, bool plain, int maxValue, int& sample)
+{
+	int value;
+	if (plain)
+	{
+		if (!readHeaderValue(data, pos, value))
+			return false;
+	}
+	else if (maxValue > 255)
+	{
+		// Samples wider than a byte are stored most significant byte first
+		if (pos + 2 > data.size())
+			return false;
+		value = ((unsigned char)data[pos] << 8) | (unsigned char)data[pos + 1];
+		pos += 2;
+	}
+	else
+	{
+		if (pos >= data.size())
+			return false;
+		value = (unsigned char)data[pos++];
+	}
+
+	sample = (min(value, maxValue) * 255 + maxValue / 2) / maxValue;
+	return true;
+}
+
+
+bool isImageFile(const char filename[])
+{
+	size_t length = strlen(filename);
+	if (length < 4)
+		return false;
+
+	const char* extension = filename + length - 4;
+	return strcmp(extension, ".pgm") == 0 || strcmp(extension, ".ppm") == 0 ||
+		strcmp(extension, ".PGM") == 0 || strcmp(extension, ".PPM") == 0;
+}
+
+
+/**
+* Loads a PGM or PPM image as 8-bit luminance. Both the plain (P2, P3)
+* and the raw (P5, P6) forms are read, with any maximum sample value.
+*
+* @param[out] image Image to load into; left empty if the file cannot be read
+* @param[in] filename Path of the image
+*/
+bool loadImage(Image& image, const char* filename)
+{
+	image.width = 0;
+	image.height = 0;
+	image.pixels.clear();
+
+	ifstream file(filename, ios::binary | ios::ate);
+	if (!file)
+		return false;
+
+	streamoff size = file.tellg();
+	if (size < 0)
+		return false;
+
+	vector<char> data((size_t)size);
+	file.seekg(0);
+	if (!file.read(data.data(), data.size()))
+		return false;
+
+	if (data.size() < 2 || data[0] != 'P')
+		return false;
+
+	bool plain = data[1] == '2' || data[1] == '3';
+	bool color = data[1] == '3' || data[1] == '6';
+	if (!plain && data[1] != '5' && data[1] != '6')
+		return false;
+
+	size_t pos = 2;
+	int width, height, maxValue;
+	if (!readHeaderValue(data, pos, width) || !readHeaderValue(data, pos, height) ||
+		!readHeaderValue(data, pos, maxValue) || width < 1 || height < 1 || maxValue < 1 || maxValue > 0xFFFF)
+		return false;
+
+	// Exactly one whitespace character separates the header from raw pixel data
+	pos++;
+
+	// Every pixel takes at least one byte in either form
+	size_t count = (size_t)width * height;
+	if (count > data.size())
+		return false;
+	if (!plain && pos + count * (color ? 3 : 1) * (maxValue > 255 ? 2 : 1) > data.size())
+		return false;
+
+	image.pixels.resize(count);
+	unsigned char* pixels = image.pixels.data();
+
+	if (!plain && maxValue == 255)
+	{
+		// The common case: the samples already are the luminance bytes
+		const unsigned char* src = (const unsigned char*)data.data() + pos;
+		if (!color)
+		{
+			memcpy(pixels, src, count);
+		}
+		else
+		{
+			// Rec. 601 weights in 8-bit fixed point; they add up to 256
+			for (size_t i = 0; i < count; i++)
+			{
+				pixels[i] = (unsigned char)((77 * src[3 * i] + 150 * src[3 * i + 1] + 29 * src[3 * i + 2] + 128) >> 8);
+			}
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			int r, g, b;
+			if (!readSample(data, pos, plain, maxValue, r))
+				return false;
+			if (color && (!readSample(data, pos, plain, maxValue, g) || !readSample(data, pos, plain, maxValue, b)))
+				return false;
+			pixels[i] = (unsigned char)(color ? (77 * r + 150 * g + 29 * b + 128) >> 8 : r);
+		}
+	}
+
+	image.width = width;
+	image.height = height;
+	return true;
+}
+
+
+// Sums each column of a band of image rows into sums
+static void sumColumns(unsigned* sums, const unsigned char* pixels, int width, int rows)
+{
+	int x = 0;
+#ifdef IMAGE_SSE2
+	// 32 columns at a time go down the whole band in 16-bit sums, which hold
+	// up to 257 rows of white, so the sums are only widened once per group
+	const int GROUPROWS = 257;
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 32 <= width; x += 32)
+	{
+		__m128i total[8];
+		for (int i = 0; i < 8; i++)
+			total[i] = zero;
+
+		for (int first = 0; first < rows; first += GROUPROWS)
+		{
+			__m128i part[4] = { zero, zero, zero, zero };
+			const unsigned char* p = pixels + (size_t)first * width + x;
+			for (int y = first; y < min(rows, first + GROUPROWS); y++, p += width)
+			{
+				__m128i left = _mm_loadu_si128((const __m128i*)p);
+				__m128i right = _mm_loadu_si128((const __m128i*)(p + 16));
+				part[0] = _mm_add_epi16(part[0], _mm_unpacklo_epi8(left, zero));
+				part[1] = _mm_add_epi16(part[1], _mm_unpackhi_epi8(left, zero));
+				part[2] = _mm_add_epi16(part[2], _mm_unpacklo_epi8(right, zero));
+				part[3] = _mm_add_epi16(part[3], _mm_unpackhi_epi8(right, zero));
+			}
+			for (int i = 0; i < 4; i++)
+			{
+				total[2 * i] = _mm_add_epi32(total[2 * i], _mm_unpacklo_epi16(part[i], zero));
+				total[2 * i + 1] = _mm_add_epi32(total[2 * i + 1], _mm_unpackhi_epi16(part[i], zero));
+			}
+		}
+
+		for (int i = 0; i < 8; i++)
+			_mm_storeu_si128((__m128i*)(sums + x + 4 * i), total[i]);
+	}
+#endif
+	// The remaining columns go row by row, which keeps the reads in order
+	for (int col = x; col < width; col++)
+	{
+		sums[col] = 0;
+	}
+	for (int y = 0; y < rows; y++)
+	{
+		const unsigned char* row = pixels + (size_t)y * width;
+		for (int col = x; col < width; col++)
+			sums[col] += row[col];
+	}
+}
+
+
+// Converts one row of the canvas from the band of image rows it covers
+static void convertRow(Canvas& canvas, int row, const Image& image, const int columnEdges[], const char ramp[], int rampLength)
+{
+	// Reused by each thread, so converting a row allocates nothing
+	thread_local vector<unsigned> sums;
+	thread_local vector<unsigned long long> prefix;
+
+	int width = image.width;
+	int firstRow = (int)((long long)row * image.height / canvas.rows());
+	int lastRow = max((int)((long long)(row + 1) * image.height / canvas.rows()), firstRow + 1);
+
+	sums.resize(width);
+	sumColumns(sums.data(), image.pixels.data() + (size_t)firstRow * width, width, lastRow - firstRow);
+
+	// Running totals give the sum over any run of columns in one subtraction,
+	// also when cells are narrower than a pixel and share columns
+	prefix.resize(width + 1);
+	prefix[0] = 0;
+	for (int x = 0; x < width; x++)
+	{
+		prefix[x + 1] = prefix[x] + sums[x];
+	}
+
+	// Cells are one of at most two widths, so the scale from a sum to a
+	// ramp position only changes when the width does
+	char* cells = canvas[row];
+	int scaleWidth = 0;
+	double scale = 0;
+	for (int col = 0; col < canvas.cols(); col++)
+	{
+		int firstCol = columnEdges[col];
+		int lastCol = max(columnEdges[col + 1], firstCol + 1);
+
+		if (lastCol - firstCol != scaleWidth)
+		{
+			scaleWidth = lastCol - firstCol;
+			scale = rampLength / (256.0 * scaleWidth * (lastRow - firstRow));
+		}
+		int glyph = (int)((prefix[lastCol] - prefix[firstCol]) * scale);
+		cells[col] = ramp[min(glyph, rampLength - 1)];
+	}
+}
+
+
+/**
+* Draws an image into a canvas, keeping the canvas size. Each cell shows
+* the average luminance of the part of the image it covers, picked from
+* the ramp, so the whole image is scaled to fit the canvas.
+*
+* @param[out] canvas Canvas to draw into
+* @param[in] image Image to convert
+* @param[in] ramp Characters from black to white; DEFAULTRAMP if NULL or empty
+* @param[in] threads Number of threads converting bands of rows (0: one per core)
+*/
+void imageToCanvas(Canvas& canvas, const Image& image, const char ramp[], int threads)
+{
+	if (image.width < 1 || image.height < 1)
+	{
+		initCanvas(canvas);
+		return;
+	}
+
+	if (ramp == NULL || ramp[0] == '\0')
+		ramp = DEFAULTRAMP;
+	int rampLength = (int)strlen(ramp);
+
+	// The first image column each canvas column covers is the same on every row
+	vector<int> columnEdges(canvas.cols() + 1);
+	for (int col = 0; col <= canvas.cols(); col++)
+	{
+		columnEdges[col] = (int)((long long)col * image.width / canvas.cols());
+	}
+
+	runParallel(canvas.rows(), threads, [&](size_t row)
+	{
+		convertRow(canvas, (int)row, image, columnEdges.data(), ramp, rampLength);
+	});
+}
+
+
+/**
+* Loads a PGM or PPM image into a canvas, scaled to the canvas size.
+*
+* @param[out] canvas Canvas to draw into; left unchanged if the image cannot be read
+* @param[in] filename Path of the image
+* @param[in] ramp Characters from black to white; DEFAULTRAMP if NULL or empty
+* @param[in] threads Number of threads converting bands of rows (0: one per core)
+*/
+bool loadImageCanvas(Canvas& canvas, const char* filename, const char ramp[], int threads)
+{
+	// Reused between calls, so converting a sequence of frames allocates once
+	thread_local Image image;
+	if (!loadImage(image, filename))
+		return false;
+
+	imageToCanvas(canvas, image, ramp, threads);
+	return true;
+}
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include "Definitions.h"
+
+using namespace std;
+
+
+// Returns true if the row holds anything other than the transparent character
+static bool isInked(const char* cells, int length, char transparent)
+{
+	for (int x = 0; x < length; x++)
+	{
+		if (cells[x] != transparent)
+			return true;
+	}
+	return false;
+}
+
+
+void LayerStack::resize(int rows, int cols)
+{
+	if (rows < 0) rows = 0;
+	if (cols < 0) cols = 0;
+
+	numRows = rows;
+	numCols = cols;
+	layers.clear();
+	invalidate();
+}
+
+
+int LayerStack::addLayer(const string& name, char transparent)
+{
+	Layer layer;
+	layer.name = name;
+	layer.canvas.resize(numRows, numCols);
+	layer.transparent = transparent;
+	layer.visible = true;
+	layers.push_back(move(layer));
+
+	// A new layer is blank, which only shows anything if blank is not transparent
+	markInked(count() - 1);
+	return count() - 1;
+}
+
+
+int LayerStack::findLayer(const string& name) const
+{
+	for (int i = 0; i < count(); i++)
+	{
+		if (layers[i].name == name)
+			return i;
+	}
+	return -1;
+}
+
+
+void LayerStack::removeLayer(int index)
+{
+	markInked(index);
+	layers.erase(layers.begin() + index);
+}
+
+
+void LayerStack::setVisible(int index, bool visible)
+{
+	if (layers[index].visible == visible)
+		return;
+
+	layers[index].visible = visible;
+	markInked(index);
+}
+
+
+void LayerStack::setTransparent(int index, char transparent)
+{
+	// Rows inked before or after the change may look different
+	markInked(index);
+	layers[index].transparent = transparent;
+	markInked(index);
+}
+
+
+Canvas& LayerStack::beginEdit(int index)
+{
+	// The layer as it was, so endEdit can tell which rows changed
+	copyCanvas(editedLayer, layers[index].canvas);
+	return layers[index].canvas;
+}
+
+
+void LayerStack::endEdit(int index)
+{
+	const Canvas& canvas = layers[index].canvas;
+	if (!layers[index].visible)
+		return;
+
+	// A layer drawn into a canvas of another size has to be redone in full
+	if (canvas.rows() != editedLayer.rows() || canvas.cols() != editedLayer.cols())
+	{
+		invalidate();
+		return;
+	}
+
+	for (int row = 0; row < numRows; row++)
+	{
+		if (!dirtyRows[row] && memcmp(canvas[row], editedLayer[row], canvas.cols()) != 0)
+			dirtyRows[row] = 1;
+	}
+}
+
+
+void LayerStack::markInked(int index)
+{
+	const Layer& layer = layers[index];
+	if (layer.canvas.rows() != numRows || layer.canvas.cols() != numCols)
+	{
+		invalidate();
+		return;
+	}
+
+	for (int row = 0; row < numRows; row++)
+	{
+		if (!dirtyRows[row] && isInked(layer.canvas[row], numCols, layer.transparent))
+			dirtyRows[row] = 1;
+	}
+}
+
+
+int LayerStack::composite(Canvas& canvas)
+{
+	if (canvas.rows() != numRows || canvas.cols() != numCols)
+	{
+		canvas.resize(numRows, numCols);
+		invalidate();
+	}
+
+	// The row padding is spaces in every layer, so whole strides are blended;
+	// a transparent character other than a space copies spaces into spaces
+	int composited = 0;
+	for (int row = 0; row < numRows; row++)
+	{
+		if (!dirtyRows[row])
+			continue;
+
+		char* out = canvas[row];
+		memset(out, ' ', canvas.stride());
+		for (size_t i = 0; i < layers.size(); i++)
+		{
+			const Layer& layer = layers[i];
+			if (layer.visible && layer.canvas.rows() == numRows && layer.canvas.cols() == numCols)
+				blendCells(out, layer.canvas[row], canvas.stride(), layer.transparent);
+		}
+		dirtyRows[row] = 0;
+		composited++;
+	}
+	return composited;
+}
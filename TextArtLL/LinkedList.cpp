@@ -1,19 +1,20 @@
 #include <iostream>
-#include <Windows.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
 #include "Definitions.h"
 using namespace std;
 
 
-Node* newCanvas()
+Node* newCanvas(int rows, int cols)
 {
-
 	//creates a new node with a blank canvas in it
 	Node* current = new Node;
-	initCanvas(current->item);
+	current->item.resize(rows, cols);
+	current->hash = hashCanvas(Canvas(rows, cols));
 	current->next = NULL;
 
 	return current;
-	//return NULL;
 }
 
 
@@ -23,11 +24,20 @@ Node* newCanvas(Node* oldNode)
 
 	//Creates a new node and copies the contents of the contents of the old node into it
 	Node* newNode = new Node;
-	for (int x = 0; x < MAXROWS; x++) {
-		for (int y = 0; y < MAXCOLS; y++) {
-			newNode->item[x][y] = oldNode->item[x][y];
-		}
-	}
+	copyCanvas(newNode->item, oldNode->item);
+	newNode->hash = oldNode->hash;
+	newNode->next = NULL;
+
+	return newNode;
+}
+
+
+Node* newCanvas(const Canvas& canvas)
+{
+	// Only the tiles holding something other than spaces are copied
+	Node* newNode = new Node;
+	copyCanvas(newNode->item, canvas);
+	newNode->hash = hashCanvas(canvas);
 	newNode->next = NULL;
 
 	return newNode;
@@ -36,18 +46,19 @@ Node* newCanvas(Node* oldNode)
 
 void play(List& clips)
 {
+	// keys are read without echo so ESC does not show up on the screen
+	beginKeyInput();
+
 	// loops as long as the ESCAPE key is not currently being pressed
-	while (!(GetKeyState(VK_ESCAPE) & 0x8000))
+	while (!escapePressed())
 	{
 		// TODO: Write the code for the function
 		if (clips.count < 2)
-			return;
-		int count = clips.count;
-
+			break;
 
 		playRecursive(clips.head, clips.count);
 	}
-
+	endKeyInput();
 }
 
 
@@ -59,20 +70,39 @@ void playRecursive(Node* head, int count)
 	//play next clip 
 
 	playRecursive(head->next, count - 1);
-	displayCanvas(head->item);
-	printf("Hold <ESC> to stop\t");
-	printf("Clips: %2d", count);
+	ScopedTimer frame(TIMEPLAYFRAME);
+
+	// Clips are stored sparse; each is spread out into one reused canvas to be shown
+	thread_local Canvas clip;
+	copyCanvas(clip, head->item);
+	beginFrame();
+	displayCanvas(clip);
+	framePrintf("Hold <ESC> to stop\t");
+	framePrintf("Clips: %2d", count);
+	endFrame();
+	frame.stop();
 	// Pause for 100 milliseconds to slow down animation
-	Sleep(100);
+	pauseFor(100);
+}
+
+
+// Returns true if the newest node of the list holds the same canvas as current
+static bool sameAsHead(const List& list, const Canvas& current, uint64_t hash)
+{
+	return list.head != NULL && sameCanvas(list.head->item, list.head->hash, current, hash);
 }
 
 
-void addUndoState(List& undoList, List& redoList, Node*& current)
+void addUndoState(List& undoList, List& redoList, const Canvas& current)
 {
 	// TODO: Write the code for the function
 
-	addNode(undoList, newCanvas(current));
-	////Add the new node to the front of the undo list
+	////Add the new node to the front of the undo list,
+	////unless it already holds this canvas
+	if (!sameAsHead(undoList, current, hashCanvas(current)))
+	{
+		addNode(undoList, newCanvas(current));
+	}
 
 
 	////Delete the redo list
@@ -81,22 +111,44 @@ void addUndoState(List& undoList, List& redoList, Node*& current)
 }
 
 
-void restore(List& undoList, List& redoList, Node*& current)
+void restore(List& undoList, List& redoList, Canvas& current)
 {
 	// TODO: Write the code for the function
 	if (undoList.head == NULL)
 		return;
-	//add the current node to the redo list
-	addNode(redoList, current);
+	//add the current canvas to the redo list
+	addNode(redoList, newCanvas(current));
 
 	//take a node from the undoList 
-	//and make it into the current node
-	current = removeNode(undoList);
+	//and make its canvas the current one
+	Node* state = removeNode(undoList);
+	copyCanvas(current, state->item);
+	delete state;
 
 
 }
 
 
+bool dropUnchangedUndoState(List& undoList, const Canvas& current)
+{
+	if (undoList.head == NULL || !sameAsHead(undoList, current, hashCanvas(current)))
+		return false;
+
+	delete removeNode(undoList);
+	return true;
+}
+
+
+bool addClip(List& clips, const Canvas& current)
+{
+	if (sameAsHead(clips, current, hashCanvas(current)))
+		return false;
+
+	addNode(clips, newCanvas(current));
+	return true;
+}
+
+
 void addNode(List& list, Node* nodeToAdd)
 {
 	// TODO: Write the code for the function
@@ -140,31 +192,76 @@ void deleteList(List& list)
 }
 
 
-bool loadClips(List& clips, char filename[])
+// Copies filename without its canvas extension into base; returns the extension,
+// or TEXTEXTENSION if filename has none
+static const char* splitExtension(const char filename[], char base[])
+{
+	snprintf(base, FILENAMESIZE, "%s", filename);
+	if (!hasCanvasExtension(base))
+	{
+		return TEXTEXTENSION;
+	}
+
+	const char* extension = isBinaryCanvasFile(base) ? BINARYEXTENSION : TEXTEXTENSION;
+	base[strlen(base) - strlen(extension)] = '\0';
+	return extension;
+}
+
+
+// Builds the path of clip number of the set named base; returns false if it
+// does not fit, since a path cut short would name another file
+static bool clipFileName(char clipPath[], const char base[], int number, const char extension[])
+{
+	int length = snprintf(clipPath, FILENAMESIZE, "%s-%d%s", base, number, extension);
+	return length >= 0 && length < FILENAMESIZE;
+}
+
+
+bool loadClips(List& clips, char filename[], int rows, int cols)
 {
 	//// TODO: Write the code for the function
 	//erase the list
 	deleteList(clips);
 
+	// A binary file holds the whole clip set
+	if (isBinaryCanvasFile(filename))
+	{
+		vector<Canvas> frames;
+		if (!loadFrames(frames, filename) || frames.empty())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			addNode(clips, newCanvas(frames[i]));
+		}
+		return true;
+	}
+
+	char base[FILENAMESIZE];
+	const char* extension = splitExtension(filename, base);
+
 	char fullFileName[FILENAMESIZE];
 	int i = 1;
 	while (true)
 	{
-		snprintf(fullFileName, FILENAMESIZE, "%s-%d.txt", filename, i);
+		if (!clipFileName(fullFileName, base, i, extension))
+		{
+			return false;
+		}
 
-		Node* current = newCanvas();
-		bool loaded = loadCanvas(current->item, fullFileName);
+		Canvas clip(rows, cols);
+		bool loaded = loadCanvas(clip, fullFileName);
 		if (loaded)
 		{
-			addNode(clips, current);
+			addNode(clips, newCanvas(clip));
 			i++;
 		}
 		if(!loaded && i < 2)
 		{
-			delete current;
 			return false;
 		}
-		else if (!loaded && i > 2)
+		else if (!loaded)
 		{
 			return true;
 		}
@@ -185,17 +282,68 @@ bool saveClips(List& clips, char filename[])
 		return false;
 	}
 
+	// A binary file holds the whole clip set, in the order the text files are numbered
+	if (isBinaryCanvasFile(filename))
+	{
+		// The frames are diffed against each other, which needs whole rows
+		vector<Canvas> dense(clips.count);
+		vector<const Canvas*> frames;
+		for (int i = 0; current != NULL; current = current->next, i++)
+		{
+			copyCanvas(dense[i], current->item);
+			frames.push_back(&dense[i]);
+		}
+
+		char clipPath[FILENAMESIZE];
+		int length = snprintf(clipPath, FILENAMESIZE, "SavedFiles/%s", filename);
+		if (length < 0 || length >= FILENAMESIZE)
+		{
+			return false;
+		}
+		return writeFramesFile(frames.data(), (int)frames.size(), clipPath);
+	}
+
 	int clipNumber = 1;
 
+	// Each clip is saved with the extension given on the name, if any
+	char base[FILENAMESIZE];
+	const char* extension = splitExtension(filename, base);
+
 	//Goes until current == NULL which would indicate the end of the list
 	//Calls the saveCanvas function in order to save the files
 	while (current != NULL)
 	{
 		char clipPath[FILENAMESIZE];
-		snprintf(clipPath, FILENAMESIZE, "%s-%d", filename, clipNumber);
-		saveCanvas(current->item, clipPath);
+		if (!clipFileName(clipPath, base, clipNumber, extension) || !saveCanvas(current->item, clipPath))
+		{
+			return false;
+		}
 		current = current->next;
 		clipNumber++;
 	}
 	return true;
-}
\ No newline at end of file
+}
+
+
+void scrollClips(List& clips, Canvas& current, int rowValue, int colValue, int frames, bool wrap)
+{
+	if (frames < 1)
+		frames = 1;
+
+	// Position reached so far; each frame moves by the difference
+	// between its rounded target and this position
+	int doneRows = 0;
+	int doneCols = 0;
+
+	for (int frame = 1; frame <= frames; frame++)
+	{
+		int targetRows = (int)round((double)rowValue * frame / frames);
+		int targetCols = (int)round((double)colValue * frame / frames);
+
+		moveCanvas(current, targetRows - doneRows, targetCols - doneCols, wrap);
+		doneRows = targetRows;
+		doneCols = targetCols;
+
+		addNode(clips, newCanvas(current));
+	}
+}
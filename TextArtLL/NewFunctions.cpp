@@ -1,7 +1,18 @@
 #include <iostream>
-#include <windows.h>
-#include <conio.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <thread>
 #include "Definitions.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FILL_SSE2
+#endif
+
 using namespace std;
 
 
@@ -11,24 +22,47 @@ Point::Point(DrawPoint p)
 	col = (int)round(p.col);
 }
 
+// cos and sin of every whole degree from -359 to 359, worked out once the
+// same way findEndPoint did for each call, so the end points do not change
+struct TrigTable
+{
+	double cosine[2 * 360 - 1];
+	double sine[2 * 360 - 1];
+
+	TrigTable()
+	{
+		for (int angle = -359; angle <= 359; angle++)
+		{
+			cosine[angle + 359] = cos(degree2radian(angle));
+			sine[angle + 359] = sin(degree2radian(angle));
+		}
+	}
+};
+
+static const TrigTable trig;
+
+
 // https://math.stackexchange.com/questions/39390/determining-end-coordinates-of-line-with-the-specified-length-and-angle
 DrawPoint findEndPoint(DrawPoint start, int len, int angle)
 {
 	DrawPoint end;
-	end.col = start.col + len * cos(degree2radian(angle));
-	end.row = start.row + len * sin(degree2radian(angle));
+
+	// Whole turns make no difference, and leave an angle the table covers
+	angle = angle % 360;
+	end.col = start.col + len * trig.cosine[angle + 359];
+	end.row = start.row + len * trig.sine[angle + 359];
 	return end;
 }
 
 
 // Use this to draw characters into the canvas, with the option of performing animation
-void drawHelper(char canvas[][MAXCOLS], Point p, char ch, bool animate)
+void drawHelper(Canvas& canvas, Point p, char ch, bool animate)
 {
 	// Pause time between steps (in milliseconds)
 	const int TIME = 50;
 
 	// Make sure point is within bounds
-	if (p.row >= 0 && p.row < MAXROWS && p.col >= 0 && p.col < MAXCOLS)
+	if (canvas.contains(p.row, p.col))
 	{
 		// Draw character into the canvas
 		canvas[p.row][p.col] = ch;
@@ -36,104 +70,284 @@ void drawHelper(char canvas[][MAXCOLS], Point p, char ch, bool animate)
 		// If animation is enabled, draw to screen at same time
 		if (animate)
 		{
+			beginFrame();
 			gotoxy(p.row, p.col);
-			printf("%c", ch);
-			Sleep(TIME);
+			frameWrite(&ch, 1);
+			endFrame();
+			pauseFor(TIME);
 		}
 	}
 }
 
 
-// Fills gaps in a row caused by mismatch between match calculations and screen coordinates
-// (i.e. the resolution of our 'canvas' isn't very good)
-void drawLineFillRow(char canvas[][MAXCOLS], int col, int startRow, int endRow, char ch, bool animate)
+// Rows of a line are worked out on a grid of LINESCALE steps per cell,
+// so whole-number arithmetic gives the same cells as the line through the
+// exact end points
+const int LINESCALE = 4096;
+
+// Lines reaching further than this from the top left corner are cut to it
+// first, which keeps the scaled products below within 64 bits
+const double LINELIMIT = 65536;
+
+// Outcode bits for Cohen-Sutherland clipping: the sides of the clip
+// rectangle a point lies beyond
+const int CLIPABOVE = 1;
+const int CLIPBELOW = 2;
+const int CLIPLEFT = 4;
+const int CLIPRIGHT = 8;
+
+
+// Returns the sides of the rectangle which p lies beyond
+static int outcode(DrawPoint p, double top, double left, double bottom, double right)
 {
-	// determine if we're counting up or down
-	if (startRow <= endRow)
-		for (int r = startRow; r <= endRow; r++)
+	int code = 0;
+	if (p.row < top)
+		code |= CLIPABOVE;
+	else if (p.row > bottom)
+		code |= CLIPBELOW;
+	if (p.col < left)
+		code |= CLIPLEFT;
+	else if (p.col > right)
+		code |= CLIPRIGHT;
+	return code;
+}
+
+
+// Cuts the segment from a to b down to the part inside the rectangle, moving
+// an end point outside it onto one edge at a time (Cohen-Sutherland);
+// returns false if no part of the segment is inside
+static bool clipSegment(DrawPoint& a, DrawPoint& b, double top, double left, double bottom, double right)
+{
+	int codeA = outcode(a, top, left, bottom, right);
+	int codeB = outcode(b, top, left, bottom, right);
+	while (codeA != 0 || codeB != 0)
+	{
+		// Both ends beyond the same side
+		if ((codeA & codeB) != 0)
+			return false;
+
+		int code = codeA != 0 ? codeA : codeB;
+		DrawPoint p;
+		if (code & CLIPABOVE)
 		{
-			Point point(r, col);
-			drawHelper(canvas, point, ch, animate);
+			p.row = top;
+			p.col = a.col + (b.col - a.col) * (top - a.row) / (b.row - a.row);
 		}
-	else
-		for (int r = startRow; r >= endRow; r--)
+		else if (code & CLIPBELOW)
+		{
+			p.row = bottom;
+			p.col = a.col + (b.col - a.col) * (bottom - a.row) / (b.row - a.row);
+		}
+		else if (code & CLIPLEFT)
+		{
+			p.col = left;
+			p.row = a.row + (b.row - a.row) * (left - a.col) / (b.col - a.col);
+		}
+		else
+		{
+			p.col = right;
+			p.row = a.row + (b.row - a.row) * (right - a.col) / (b.col - a.col);
+		}
+
+		if (codeA != 0)
 		{
-			Point point(r, col);
-			drawHelper(canvas, point, ch, animate);
+			a = p;
+			codeA = outcode(a, top, left, bottom, right);
 		}
+		else
+		{
+			b = p;
+			codeB = outcode(b, top, left, bottom, right);
+		}
+	}
+	return true;
 }
 
 
-// Draw a single line from start point to end point
-void drawLine(char canvas[][MAXCOLS], DrawPoint start, DrawPoint end, bool animate)
+// Returns x * LINESCALE rounded to a whole number, halves away from zero
+static long long toLineScale(double x)
+{
+	x *= LINESCALE;
+	return x >= 0 ? (long long)(x + 0.5) : -(long long)(0.5 - x);
+}
+
+
+// Returns n / d rounded down, with the remainder from 0 to d - 1 whatever the
+// sign of n; d must be positive. A floating point division, much quicker
+// than a 64-bit whole number one, gives the quotient to within one.
+static long long floorQuotient(long long n, long long d, long long& remainder)
+{
+	long long quotient = (long long)((double)n / d);
+	remainder = n - quotient * d;
+	while (remainder < 0)
+	{
+		quotient--;
+		remainder += d;
+	}
+	while (remainder >= d)
+	{
+		quotient++;
+		remainder -= d;
+	}
+	return quotient;
+}
+
+
+// Fills gaps in a row caused by mismatch between match calculations and screen coordinates
+// (i.e. the resolution of our 'canvas' isn't very good). The rows off the canvas are cut
+// once, so the cells are written without checking each one.
+void drawLineFillRow(Canvas& canvas, int col, int startRow, int endRow, char ch, bool animate)
+{
+	if (col < 0 || col >= canvas.cols() || max(startRow, endRow) < 0 || min(startRow, endRow) >= canvas.rows())
+		return;
+
+	// determine if we're counting up or down
+	int step = startRow <= endRow ? 1 : -1;
+	startRow = min(max(startRow, 0), canvas.rows() - 1);
+	endRow = min(max(endRow, 0), canvas.rows() - 1);
+
+	for (int r = startRow; r != endRow + step; r += step)
+	{
+		if (animate)
+			drawHelper(canvas, Point(r, col), ch, animate);
+		else
+			canvas[r][col] = ch;
+	}
+}
+
+
+// Works out the cells of the line from start to end on a canvas of
+// canvasRows x canvasCols, and hands them to plot(col, fromRow, toRow, ch)
+// a column at a time, in drawing order. Only columns on the canvas are
+// handed over, but their rows may run off it.
+template <class Plot>
+static void rasterLine(int canvasRows, int canvasCols, DrawPoint start, DrawPoint end, Plot plot)
 {
 	char ch;
 
+	if (canvasRows == 0 || canvasCols == 0)
+		return;
+
+	// Far away parts of the line can never reach the canvas
+	if (max(max(fabs(start.row), fabs(start.col)), max(fabs(end.row), fabs(end.col))) > LINELIMIT &&
+		!clipSegment(start, end, -LINELIMIT, -LINELIMIT, LINELIMIT, LINELIMIT))
+	{
+		return;
+	}
+
 	Point scrStart(start);
 	Point scrEnd(end);
 
 	// vertical line
 	if (scrStart.col == scrEnd.col)
 	{
-		ch = '|';
+		if (scrStart.col >= 0 && scrStart.col < canvasCols)
+			plot(scrStart.col, scrStart.row, scrEnd.row, '|');
+		return;
+	}
+
+	// determine the slope of the line
+	double slope = (start.row - end.row) / (start.col - end.col);
 
-		drawLineFillRow(canvas, scrStart.col, scrStart.row, scrEnd.row, ch, animate);
+	// choose appropriate characters based on 'steepness' and direction of slope
+	if (slope > 1.8)  ch = '|';
+	else if (slope > 0.08)  ch = '`';
+	else if (slope > -0.08)  ch = '-';
+	else if (slope > -1.8) ch = '\'';
+	else ch = '|';
+
+	// The row at column col is the line's row there, rounded:
+	// (base + rowStep * col) / divisor, in units of 1 / LINESCALE
+	long long startRow = toLineScale(start.row);
+	long long startCol = toLineScale(start.col);
+	long long rows = toLineScale(end.row) - startRow;
+	long long cols = toLineScale(end.col) - startCol;
+	if (cols == 0)
+		cols = scrEnd.col > scrStart.col ? 1 : -1;
+	if (cols < 0)
+	{
+		rows = -rows;
+		cols = -cols;
 	}
-	// non-vertical line
-	else
+	long long base = startRow * cols - rows * startCol;
+	long long rowStep = rows * LINESCALE;
+	long long divisor = cols * LINESCALE;
+
+	// Each column is drawn from the row of the column before it, to fill in
+	// row gaps, so the first column only starts the line. Only the columns
+	// around the part of the line over the canvas are visited.
+	int dir = scrEnd.col > scrStart.col ? 1 : -1;
+	int first = min(scrStart.col, scrEnd.col);
+	int last = max(scrStart.col, scrEnd.col);
+	if (scrStart.row < 0 || scrStart.row >= canvasRows || scrStart.col < 0 || scrStart.col >= canvasCols ||
+		scrEnd.row < 0 || scrEnd.row >= canvasRows || scrEnd.col < 0 || scrEnd.col >= canvasCols)
 	{
-		int row = -1, prevRow;
+		DrawPoint a, b;
+		a.row = (base + rowStep * first) / (double)divisor;
+		a.col = first;
+		b.row = (base + rowStep * last) / (double)divisor;
+		b.col = last;
+		if (!clipSegment(a, b, -1, -1, canvasRows, canvasCols))
+			return;
+		first = max(first, (int)min(a.col, b.col) - 2);
+		last = min(last, (int)max(a.col, b.col) + 2);
+	}
 
-		// determine the slope of the line
-		double slope = (start.row - end.row) / (start.col - end.col);
+	int from = dir > 0 ? first : last;
+	int to = dir > 0 ? last : first;
 
-		// choose appropriate characters based on 'steepness' and direction of slope
-		if (slope > 1.8)  ch = '|';
-		else if (slope > 0.08)  ch = '`';
-		else if (slope > -0.08)  ch = '-';
-		else if (slope > -1.8) ch = '\'';
-		else ch = '|';
+	// The row plus a half, as a whole part and a remainder over twice the
+	// divisor, stepped from column to column like Bresenham's error term.
+	// It starts a column early, for the row the first column is drawn from.
+	long long twice = 2 * divisor;
+	long long rest, stepRest;
+	long long whole = floorQuotient(2 * (base + rowStep * (from - dir)) + divisor, twice, rest);
+	long long stepWhole = floorQuotient(2 * rowStep * dir, twice, stepRest);
+	int prevRow = 0;
+	for (int col = from - dir; col != to + dir; col += dir)
+	{
+		// No remainder is an exact half, which round() takes away from zero
+		int row = (int)(rest == 0 && whole <= 0 ? whole - 1 : whole);
+		if (col != from - dir && col != scrStart.col && col >= 0 && col < canvasCols)
+			plot(col, prevRow, row, ch);
+		prevRow = row;
 
-		// determine if columns are counting up or down
-		if (scrStart.col <= scrEnd.col)
-		{
-			// for each column from start to end, calculate row values
-			for (int col = scrStart.col; col <= scrEnd.col; col++)
-			{
-				prevRow = row;
-				row = (int)round(slope * (col - start.col) + start.row);
+		// Carry without a branch, which short lines would mispredict half the time
+		rest += stepRest;
+		long long carry = rest >= twice;
+		whole += stepWhole + carry;
+		rest -= carry * twice;
+	}
+}
 
-				// draw from previous row to current row (to fill in row gaps)
-				if (prevRow > -1)
-				{
-					drawLineFillRow(canvas, col, prevRow, row, ch, animate);
-				}
-			}
-		}
-		else
-		{
-			// for each column from start to end, calculate row values
-			for (int col = scrStart.col; col >= scrEnd.col; col--)
-			{
-				prevRow = row;
-				row = (int)round(slope * (col - start.col) + start.row);
 
-				// draw from previous row to current row (to fill in row gaps)
-				if (prevRow > -1)
-				{
-					drawLineFillRow(canvas, col, prevRow, row, ch, animate);
-				}
-			}
-		}
+// Draw a single line from start point to end point
+void drawLine(Canvas& canvas, DrawPoint start, DrawPoint end, bool animate)
+{
+	if (animate)
+	{
+		rasterLine(canvas.rows(), canvas.cols(), start, end, [&](int col, int fromRow, int toRow, char ch)
+		{
+			drawLineFillRow(canvas, col, fromRow, toRow, ch, animate);
+		});
+		return;
 	}
+
+	// Without animation the order does not matter, so go down each column
+	rasterLine(canvas.rows(), canvas.cols(), start, end, [&](int col, int fromRow, int toRow, char ch)
+	{
+		int bottom = min(max(fromRow, toRow), canvas.rows() - 1);
+		for (int r = max(min(fromRow, toRow), 0); r <= bottom; r++)
+			canvas[r][col] = ch;
+	});
 }
 
 
 // Draws a single box around a center point
-void drawBox(char canvas[][MAXCOLS], Point center, int height, bool animate)
+void drawBox(Canvas& canvas, Point center, int height, bool animate)
 {
 	int sizeHalf = height / 2;
-	int ratio = (int)round(MAXCOLS / (double)MAXROWS * sizeHalf);
+	int ratio = (int)round(canvas.cols() / (double)canvas.rows() * sizeHalf);
 
 	// Calculate where the four corners of the box should be
 	DrawPoint points[4];
@@ -158,7 +372,7 @@ void drawBox(char canvas[][MAXCOLS], Point center, int height, bool animate)
 
 
 // Menu for the drawing tools
-void menuTwo(Node*& current, List& undoList, List& redoList, List& clips, bool& animate)
+void menuTwo(Canvas& current, List& undoList, List& redoList, List& clips, Canvas& clipboard, bool& animate)
 {
 	// TODO: Write the code for the function
 	char menuSelection;
@@ -166,93 +380,104 @@ void menuTwo(Node*& current, List& undoList, List& redoList, List& clips, bool&
 	int heightNestedBox = 0;
 	int startAngle = 270;
 	int branchAngle = 0;
-	int row = 0;
-	int col = 0;
-	char oldCh = '0';
-	char newCh = '0';
 	char animateStatus;
 	char pos;
 	bool flagMenu = true;
 	Point center;
 	Point start, end;
 	int heightBox = 0;
-	Node* backUp = newCanvas(current);
-	char menuOther[] = "<A>nimate: N / <U>ndo: 0 / Cl<I>p: 0\n";
-	char menu[] = "<F>ill / <L>ine / <B>ox / <N>ested Boxes / <T>ree / <M>ain Menu: ";
+	char fileStamp[FILENAMESIZE];
+	char menu[] = "<F>ill / <L>ine / <B>ox / <N>ested Boxes / <T>ree / <C>opy / <X> Cut / <V> Paste / <S>tamp / <M>ain Menu: ";
 
 	while (flagMenu)
 	{
-		displayCanvas(current->item);
+		ScopedTimer display(TIMEDISPLAY);
+		beginFrame();
+		displayCanvas(current);
 
 		animateStatus = animate ? 'Y' : 'N';
 
-		clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+		clearLine(current.rows() + 1);
 		//printf("%s", menuOther);
 		if (undoList.count >= 0 && redoList.count == 0 && clips.count < 2) //inital menu
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d \n", animateStatus, undoList.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d \n", animateStatus, undoList.count, clips.count);
 
 		}
 		if (clips.count >= 2 && redoList.count == 0) // with just play
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undoList.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undoList.count, clips.count);
 		}
 		if (redoList.count > 0 && clips.count < 2) // with just redo, if undo action was done
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d \n", animateStatus, undoList.count, redoList.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d \n", animateStatus, undoList.count, redoList.count, clips.count);
 		}
 		if (redoList.count > 0 && clips.count >= 2) // with the redo and play option 
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undoList.count, redoList.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undoList.count, redoList.count, clips.count);
 		}
 
-		printf("%s", menu);
+		framePrintf("%s", menu);
+		endFrame();
+		display.stop();
 		cin >> menuSelection;
-		clearLine(MAXROWS + 2, MAXCOLS + BUFFERSIZE);
-		clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+		clearLine(current.rows() + 2);
+		clearLine(current.rows() + 1);
 		menuSelection = toupper(menuSelection);
 
+		// Started by the tool chosen, once its prompts are answered
+		ScopedTimer timer;
+
 		switch (menuSelection)
 		{
 		case 'A':
 			animate = !animate;
 			break;
 		case 'U':
+			timer.start(TIMEUNDO);
 			restore(undoList, redoList, current);
 			break;
 		case 'O':
+			timer.start(TIMEREDO);
 			restore(redoList, undoList, current);
 			break;
 		case 'I':
-			addNode(clips, newCanvas(current));
+			timer.start(TIMECLIP);
+			addClip(clips, current);
 			break;
 		case 'P':
 			play(clips);
 			break;
 		case 'F':
 			cout << "Enter character to fill with from current location / <ESC> to cancel";
-			menuSelection = getPoint(start);
+			menuSelection = getPoint(current, start);
 			if (menuSelection != ESC)
 			{
+				gotoxy(current.rows() + 1, 0); // brings cursor back to print next statement
+				clearLine(current.rows() + 1);
+				cout << "Fill through corners too? <Y>es / <N>o: ";
+				cin >> pos;
+				timer.start(TIMEFILL);
 				addUndoState(undoList, redoList, current);
-				fillRecursive(current->item, start.row, start.col, current->item[start.row][start.col], menuSelection, animate);
+				fillScanline(current, start.row, start.col, menuSelection, toupper(pos) == 'Y', animate);
 
 			}
-			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+			clearLine(current.rows() + 1);
 			break;
 		case 'L':
 			printf("Type any letter to choose start point / <ESC> to cancel");
-			pos = getPoint(start);
+			pos = getPoint(current, start);
 			if (pos != ESC)
 			{
-				gotoxy(MAXROWS + 1, 0); // brings cursor back to print next statement
-				clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+				gotoxy(current.rows() + 1, 0); // brings cursor back to print next statement
+				clearLine(current.rows() + 1);
 				printf("Type any letter to choose end point / <ESC> to cancel");
-				pos = getPoint(end);
+				pos = getPoint(current, end);
 				if (pos != ESC)
 				{
+					timer.start(TIMELINE);
 					addUndoState(undoList, redoList, current);
-					drawLine(current->item, start, end, animate);
+					drawLine(current, start, end, animate);
 
 				}
 			}
@@ -260,72 +485,161 @@ void menuTwo(Node*& current, List& undoList, List& redoList, List& clips, bool&
 		case 'B':
 			cout << "Enter size: ";
 			cin >> heightBox;
-			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+			clearLine(current.rows() + 1);
 			printf("Type any letter to choose box center, or <C> for screen center / <ESC> to cancel");
-			pos = getPoint(center);
+			pos = getPoint(current, center);
 			pos = toupper(pos);
 			if (pos != ESC)
 			{
 				if (pos == 'C')
 				{
 				
-					center = Point(MAXROWS / 2, MAXCOLS / 2);
+					center = Point(current.rows() / 2, current.cols() / 2);
 				}
+				timer.start(TIMEBOX);
 				addUndoState(undoList, redoList, current);
-				drawBox(current->item, center, heightBox, animate);
+				drawBox(current, center, heightBox, animate);
 			}
-			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+			clearLine(current.rows() + 1);
 			break;
 		case 'N':
 			cout << "Enter size of largest box: ";
 			cin >> heightNestedBox;
-			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+			clearLine(current.rows() + 1);
 			cout << "Type any letter to choose box center, or <C> for center / <ESC>";
-			pos = getPoint(center);
+			pos = getPoint(current, center);
 			pos = toupper(pos);
 			if (pos != ESC)
 			{
 				if (pos == 'C')
 				{
 				
-					center = Point(MAXROWS / 2, MAXCOLS / 2);
+					center = Point(current.rows() / 2, current.cols() / 2);
 				}
+				timer.start(TIMEBOXES);
 				addUndoState(undoList, redoList, current);
-				drawBoxesRecursive(current->item, center, heightNestedBox, animate);
+				drawBoxesRecursive(current, center, heightNestedBox, animate);
 			}
-			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+			clearLine(current.rows() + 1);
 			break;
 		case 'T':
 			cout << "Enter approximate tree height: ";
 			cin >> height;
-			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+			clearLine(current.rows() + 1);
 			cout << "Enter branch angle: ";
 			cin >> branchAngle;
-			clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+			clearLine(current.rows() + 1);
 			printf("Type any letter to choose a start point, or <C> for bottom center / <ESC> to cancel");
-			pos = getPoint(center);
+			pos = getPoint(current, center);
 			pos = toupper(pos);
 			if (pos != ESC)
 			{
 				if (pos == 'C')
 				{
 				
-					center = Point(MAXROWS - 1, MAXCOLS / 2);
+					center = Point(current.rows() - 1, current.cols() / 2);
 				}
+				timer.start(TIMETREE);
 				addUndoState(undoList, redoList, current);
-				treeRecursive(current->item, center, height, startAngle, branchAngle, animate);
+				// Without animation the order on screen does not matter, so every core can draw
+				if (animate)
+					treeRecursive(current, center, height, startAngle, branchAngle, animate);
+				else
+					treeParallel(current, center, height, startAngle, branchAngle, 0);
+			}
+			break;
+		case 'C':
+		case 'X':
+			printf("Type any letter to choose one corner / <ESC> to cancel");
+			pos = getPoint(current, start);
+			if (pos != ESC)
+			{
+				gotoxy(current.rows() + 1, 0); // brings cursor back to print next statement
+				clearLine(current.rows() + 1);
+				printf("Type any letter to choose the opposite corner / <ESC> to cancel");
+				pos = getPoint(current, end);
+				if (pos != ESC)
+				{
+					timer.start(TIMECOPY);
+					if (menuSelection == 'C')
+					{
+						copyRegion(clipboard, current, start, end);
+					}
+					else
+					{
+						addUndoState(undoList, redoList, current);
+						cutRegion(clipboard, current, start, end);
+					}
+				}
+			}
+			clearLine(current.rows() + 1);
+			break;
+		case 'V':
+			if (clipboard.rows() == 0)
+			{
+				printf("Nothing has been copied yet");
+				waitForKey(" - press any key to continue . . .");
+				break;
+			}
+			printf("Type any letter to choose the top left corner, or <O> to paste the spaces too / <ESC> to cancel");
+			pos = getPoint(current, start);
+			pos = toupper(pos);
+			if (pos != ESC)
+			{
+				timer.start(TIMEPASTE);
+				addUndoState(undoList, redoList, current);
+				pasteCanvas(current, clipboard, start, pos == 'O');
+			}
+			clearLine(current.rows() + 1);
+			break;
+		case 'S':
+			cout << "Enter the filename of the art to stamp (add '.rle' for binary): ";
+			cin.ignore();
+			cin.getline(fileStamp, FILENAMESIZE);
+			clearLine(current.rows() + 1);
+			printf("Type any letter to choose the top left corner / <ESC> to cancel");
+			pos = getPoint(current, start);
+			if (pos != ESC)
+			{
+				// The art is looked up in the SavedFiles folder, like the main menu's Load
+				char preFix[FILENAMESIZE] = "SavedFiles/";
+				int lengthP = strlen(preFix);
+				int written = snprintf(preFix + lengthP, FILENAMESIZE - lengthP, "%s%s", fileStamp, hasCanvasExtension(fileStamp) ? "" : TEXTEXTENSION);
+				if (written < 0 || written >= FILENAMESIZE - lengthP)
+				{
+					// A path cut short would stamp a different file
+					clearLine(current.rows() + 1);
+					cerr << "ERROR: File name is too long";
+					waitForKey(" - press any key to continue . . .");
+				}
+				else
+				{
+					timer.start(TIMESTAMP);
+					addUndoState(undoList, redoList, current);
+					if (!stampCanvas(current, preFix, start))
+					{
+						timer.stop();
+						clearLine(current.rows() + 1);
+						cerr << "ERROR: File cannot be read";
+						waitForKey(" - press any key to continue . . .");
+					}
+				}
 			}
+			clearLine(current.rows() + 1);
 			break;
 		case 'M':
 			flagMenu = false;
 			break;
 		}
+
+		// Operations which changed nothing leave no undo state
+		dropUnchangedUndoState(undoList, current);
 	}
 }
 
 
 // Get a single point from screen, with character entered at that point
-char getPoint(Point& pt)
+char getPoint(const Canvas& canvas, Point& pt)
 {
 	char input;
 
@@ -333,7 +647,8 @@ char getPoint(Point& pt)
 	int col = 0;
 	//Move cursor to row,col and then get a signle character from the keybaord, so like initialize it 
 	gotoxy(row, col);
-	input = _getch();
+	beginKeyInput();
+	input = getKey();
 
 	//from edit function
 	while (input != ESC)
@@ -343,7 +658,7 @@ char getPoint(Point& pt)
 		if (input == SPECIAL)
 		{
 
-			input = _getch();
+			input = getKey();
 
 			switch (input)
 			{
@@ -351,13 +666,13 @@ char getPoint(Point& pt)
 				if (col > 0) col--;
 				break;
 			case RIGHTARROW:
-				if (col < MAXCOLS - 1) col++;
+				if (col < canvas.cols() - 1) col++;
 				break;
 			case UPARROW:
 				if (row > 0) row--;
 				break;
 			case DOWNARROW:
-				if (row < MAXROWS - 1) row++;
+				if (row < canvas.rows() - 1) row++;
 				break;
 			default:
 				break;
@@ -367,7 +682,7 @@ char getPoint(Point& pt)
 		// Ignore the function keys
 		else if (input == '\0')
 		{
-			input = _getch();
+			input = getKey();
 		}
 
 		// Printable ASCII characters
@@ -375,34 +690,40 @@ char getPoint(Point& pt)
 		{
 			pt.row = row;
 			pt.col = col;
-			cout << input;
+			frameWrite(&input, 1);
+			invalidateDisplay(row, col);
+			endKeyInput();
 			return input;
 		}
 
 		else if (input == ESC)
 		{
+			endKeyInput();
 			return ESC;
 		}
 
 		gotoxy(row, col); // Moves cursor to the new position
-		input = _getch(); //get user unput
+		input = getKey(); //get user unput
 	}
+	endKeyInput();
+	return ESC;
 }
 
 
 // Recursively fill a section of the screen
-void fillRecursive(char canvas[][MAXCOLS], int row, int col, char oldCh, char newCh, bool animate)
+void fillRecursive(Canvas& canvas, int row, int col, char oldCh, char newCh, bool animate)
 {
 	Point p;
 	p.row = row;
 	p.col = col;
 
 	// base case: checks if it is outside of the array
-	if (row >= MAXROWS || row < 0 || col >= MAXCOLS || col < 0)
+	if (!canvas.contains(row, col))
 		return;
 
-	// base case: the character at current position is not being replaced
-	if (canvas[row][col] != oldCh)
+	// base case: the character at current position is not being replaced,
+	// or replacing it changes nothing (which would never stop)
+	if (canvas[row][col] != oldCh || oldCh == newCh)
 		return;
 
 	// recursive cases
@@ -414,35 +735,395 @@ void fillRecursive(char canvas[][MAXCOLS], int row, int col, char oldCh, char ne
 }
 
 
-// Recursively draw a tree
-void treeRecursive(char canvas[][MAXCOLS], DrawPoint start, int height, int startAngle, int branchAngle, bool animate)
+// Returns the first position from start on, before end, where cells holds ch
+// (same true) or does not hold ch (same false); end if there is none
+static int findCell(const char* cells, int start, int end, char ch, bool same)
 {
-	//base case, check to make sure the tree is the minimum height
-	if (height < 3)
+	int x = start;
+#ifdef FILL_SSE2
+	const __m128i match = _mm_set1_epi8(ch);
+	const int wanted = same ? 0 : 0xFFFF;
+	for (; x + 16 <= end; x += 16)
 	{
+		int found = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(cells + x)), match));
+		if (found != wanted)
+		{
+			found = same ? found : ~found & 0xFFFF;
+			int offset = 0;
+			while (!(found & (1 << offset)))
+				offset++;
+			return x + offset;
+		}
+	}
+#endif
+	while (x < end && (cells[x] == ch) != same)
+		x++;
+	return x;
+}
+
+
+// Returns the leftmost position of the run of ch which ends at end - 1
+static int runStart(const char* cells, int end, char ch)
+{
+	int x = end;
+#ifdef FILL_SSE2
+	const __m128i match = _mm_set1_epi8(ch);
+	while (x >= 16 && _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(cells + x - 16)), match)) == 0xFFFF)
+		x -= 16;
+#endif
+	while (x > 0 && cells[x - 1] == ch)
+		x--;
+	return x;
+}
+
+
+// Fill the area around a point one run of cells at a time
+void fillScanline(Canvas& canvas, int row, int col, char newCh, bool diagonal, bool animate)
+{
+	// Pause time between runs (in milliseconds)
+	const int TIME = 50;
+
+	if (!canvas.contains(row, col) || canvas[row][col] == newCh)
 		return;
+
+	char oldCh = canvas[row][col];
+	int reach = diagonal ? 1 : 0;
+
+	// Cells to fill from, kept on the heap, so the shape of the area cannot
+	// overflow the stack; reused between calls
+	thread_local vector<Point> seeds;
+	seeds.clear();
+	seeds.push_back(Point(row, col));
+
+	while (!seeds.empty())
+	{
+		Point seed = seeds.back();
+		seeds.pop_back();
+
+		// Another run may have filled this one already
+		char* cells = canvas[seed.row];
+		if (cells[seed.col] != oldCh)
+			continue;
+
+		// Widen the seed to the whole run of oldCh around it and fill that
+		int left = runStart(cells, seed.col, oldCh);
+		int right = findCell(cells, seed.col, canvas.cols(), oldCh, false) - 1;
+		memset(cells + left, newCh, right - left + 1);
+
+		if (animate)
+		{
+			beginFrame();
+			gotoxy(seed.row, left);
+			frameWrite(cells + left, right - left + 1);
+			endFrame();
+			pauseFor(TIME);
+		}
+
+		// Each run of oldCh touching this one in the rows above and below,
+		// corners too if diagonal, gets one seed
+		int first = max(left - reach, 0);
+		int last = min(right + reach, canvas.cols() - 1);
+		for (int next = seed.row - 1; next <= seed.row + 1; next += 2)
+		{
+			if (next < 0 || next >= canvas.rows())
+				continue;
+
+			const char* nextCells = canvas[next];
+			int x = findCell(nextCells, first, last + 1, oldCh, true);
+			while (x <= last)
+			{
+				seeds.push_back(Point(next, x));
+				x = findCell(nextCells, findCell(nextCells, x, last + 1, oldCh, false), last + 1, oldCh, true);
+			}
+		}
+	}
+}
+
+
+// One branch of the tree still to be drawn, with the branches above it;
+// depth counts the trunks below it
+struct TreeBranch
+{
+	DrawPoint start;
+	int height;
+	int angle;
+	int depth;
+};
+
+
+// What all the branches of one tree have in common
+struct TreeShape
+{
+	// How far a branch of each height, with everything above it, can reach
+	// from its start; the trunks get shorter by at most a cell per level
+	vector<int> reach;
+
+	// How many rows past its ends drawLine may run a trunk on, at most
+	double spill;
+
+	int branchAngle;
+};
+
+
+// Works out the shape of a tree of the given height and angles
+static void shapeTree(TreeShape& shape, int height, int startAngle, int branchAngle)
+{
+	shape.reach.assign(height + 1, 0);
+	for (int h = 3; h <= height; h++)
+		shape.reach[h] = h / 3 + shape.reach[h - 2];
+
+	// drawLine runs a slanted line on to the rows at the whole columns around
+	// its ends, up to half a column past them; find the most any angle of the
+	// tree can add that way. The angles are the start angle plus or minus up
+	// to one branch angle per level, and vertical lines do not run on.
+	shape.spill = 0;
+	for (int k = -height / 2; k <= height / 2; k++)
+	{
+		int angle = (int)(((long long)startAngle + (long long)k * branchAngle) % 360);
+		if (fabs(trig.cosine[angle + 359]) > 1e-6)
+			shape.spill = max(shape.spill, fabs(trig.sine[angle + 359] / trig.cosine[angle + 359]) / 2);
 	}
+
+	shape.branchAngle = branchAngle;
+}
+
+
+// Returns true if the branch and everything above it cannot reach a canvas
+// of rows x cols, with a cell to spare for rounding
+static bool branchMisses(const TreeShape& shape, const TreeBranch& branch, int rows, int cols)
+{
+	double far = shape.reach[branch.height] + 1;
+	return branch.start.row + far + shape.spill < 0 || branch.start.row - far - shape.spill >= rows ||
+		branch.start.col + far < 0 || branch.start.col - far >= cols;
+}
+
+
+// Draws the trunk of the branch with drawTrunk(start, end), and pushes the
+// branches above it onto branches, the first one on top so it is drawn first
+template <class DrawTrunk>
+static void growBranch(const TreeShape& shape, const TreeBranch& branch, vector<TreeBranch>& branches, DrawTrunk drawTrunk)
+{
 	//Correctly initializes trunkHeight
-	int trunkHeight = height / 3;
+	int trunkHeight = branch.height / 3;
 
 	//Ensures that the the angle will never be allowed to have a value over 359
-	startAngle = startAngle % 360;
+	int angle = branch.angle % 360;
 
 	//finds the endpoint of the trunk
-	DrawPoint endTrunk = findEndPoint(start, trunkHeight, startAngle);
+	DrawPoint endTrunk = findEndPoint(branch.start, trunkHeight, angle);
 
 	//draws the trunk
-	drawLine(canvas, start, endTrunk, animate);
+	drawTrunk(branch.start, endTrunk);
 
-	//Recursive steps to draw the branches
-	treeRecursive(canvas, endTrunk, height - 2, startAngle - branchAngle, branchAngle, animate);
-	treeRecursive(canvas, endTrunk, height - 2, startAngle + branchAngle, branchAngle, animate);
+	if (branch.height - 2 >= 3)
+	{
+		branches.push_back({ endTrunk, branch.height - 2, angle + shape.branchAngle, branch.depth + 1 });
+		branches.push_back({ endTrunk, branch.height - 2, angle - shape.branchAngle, branch.depth + 1 });
+	}
+}
 
+
+// Draws the branch and everything above it in the order recursion would,
+// keeping the branches still to be drawn on a stack; leaves out the
+// branches which cannot reach a canvas of rows x cols
+template <class DrawTrunk>
+static void walkTree(const TreeShape& shape, const TreeBranch& root, int rows, int cols, vector<TreeBranch>& branches,
+	DrawTrunk drawTrunk)
+{
+	branches.clear();
+	branches.push_back(root);
+	while (!branches.empty())
+	{
+		TreeBranch branch = branches.back();
+		branches.pop_back();
+		if (!branchMisses(shape, branch, rows, cols))
+			growBranch(shape, branch, branches, drawTrunk);
+	}
+}
+
+
+// Draw a fractal tree, branch by branch in the order recursion drew them
+void treeRecursive(Canvas& canvas, DrawPoint start, int height, int startAngle, int branchAngle, bool animate)
+{
+	//base case, check to make sure the tree is the minimum height
+	if (height < 3)
+	{
+		return;
+	}
+
+	// Reused between calls, so drawing another tree allocates nothing
+	thread_local TreeShape shape;
+	thread_local vector<TreeBranch> branches;
+	shapeTree(shape, height, startAngle, branchAngle);
+	walkTree(shape, { start, height, startAngle, 0 }, canvas.rows(), canvas.cols(), branches, [&](DrawPoint from, DrawPoint to)
+	{
+		drawLine(canvas, from, to, animate);
+	});
+}
+
+
+// Finds the rectangle every cell of a tree is drawn inside of
+void treeBounds(DrawPoint start, int height, int startAngle, int branchAngle,
+	double& top, double& left, double& bottom, double& right)
+{
+	thread_local TreeShape shape;
+	shapeTree(shape, max(height, 0), startAngle, branchAngle);
+
+	// The same margins branchMisses leaves around the whole tree
+	double far = shape.reach[max(height, 0)] + 1;
+	top = start.row - far - shape.spill;
+	bottom = start.row + far + shape.spill;
+	left = start.col - far;
+	right = start.col + far;
+}
+
+
+// Each parallel tree job is a branch whose number of trunks below it makes
+// at least this many jobs per thread, so stealing evens out pruned ones
+const int TREEJOBSPERTHREAD = 16;
+
+// Trees with fewer levels of branches above the jobs are drawn on one
+// thread, as starting the threads would take longer
+const int TREEMINLEVELS = 6;
+
+// A cell write in a parallel tree is stamped with the place of its line or
+// job in drawing order, from bit TREEORDERSHIFT up; the number of the write
+// within the job, from bit 8; and the character, in the low byte. The
+// largest stamp a cell gets is the write drawing in order would leave.
+// That allows 2^32 column writes per job, more than any tree which
+// finishes in a day would make.
+const int TREEORDERSHIFT = 40;
+
+
+// A branch drawn on its own by one thread, and its place in drawing order
+struct TreeJob
+{
+	TreeBranch branch;
+	unsigned long long order;
+};
+
+
+// Stamps the cells of column col from fromRow to toRow which are on a canvas
+// of rows rows, wherever stamp is later than the stamp already there
+static void stampColumn(atomic<unsigned long long>* stamps, int rows, int cols, int col, int fromRow, int toRow,
+	unsigned long long stamp)
+{
+	int bottom = min(max(fromRow, toRow), rows - 1);
+	for (int r = max(min(fromRow, toRow), 0); r <= bottom; r++)
+	{
+		atomic<unsigned long long>& cell = stamps[(size_t)r * cols + col];
+		unsigned long long old = cell.load(memory_order_relaxed);
+		while (old < stamp && !cell.compare_exchange_weak(old, stamp, memory_order_relaxed))
+		{
+		}
+	}
+}
+
+
+/**
+* Draws a fractal tree like treeRecursive without animation, with the
+* branches above a split depth spread over several threads.
+*
+* @param[in, out] canvas Canvas to draw into; the same as treeRecursive would leave it
+* @param[in] start Base of the trunk
+* @param[in] height Approximate height of the entire tree
+* @param[in] startAngle Direction of the trunk: 0 = east, 90 = south, 180 = west, 270 = north
+* @param[in] branchAngle Angle of each branch to the trunk below it
+* @param[in] threads Number of threads (0: one per core)
+*/
+void treeParallel(Canvas& canvas, DrawPoint start, int height, int startAngle, int branchAngle, int threads)
+{
+	if (threads <= 0)
+		threads = max(1, (int)thread::hardware_concurrency());
+
+	// The depth with enough branches for every thread to have plenty of jobs
+	int split = 0;
+	while ((1 << split) < TREEJOBSPERTHREAD * threads)
+		split++;
+
+	int levels = height < 3 ? 0 : (height - 3) / 2 + 1;
+	if (threads == 1 || levels < split + TREEMINLEVELS)
+	{
+		treeRecursive(canvas, start, height, startAngle, branchAngle, false);
+		return;
+	}
+
+	int rows = canvas.rows();
+	int cols = canvas.cols();
+	size_t cells = (size_t)rows * cols;
+
+	// Reused between calls, with the stamps left all 0 after each one. The
+	// threads share this thread's copies, through references.
+	thread_local TreeShape treeShape;
+	thread_local vector<atomic<unsigned long long>> cellStamps;
+	if (cellStamps.size() < cells)
+		cellStamps = vector<atomic<unsigned long long>>(cells);
+	TreeShape& shape = treeShape;
+	atomic<unsigned long long>* stamps = cellStamps.data();
+	shapeTree(shape, height, startAngle, branchAngle);
+
+	// Draw the trunks below the split depth here, and number them and the
+	// branches at the split depth in the order they would be drawn in
+	vector<TreeJob> jobs;
+	vector<TreeBranch> branches;
+	unsigned long long order = 0;
+	branches.push_back({ start, height, startAngle, 0 });
+	while (!branches.empty())
+	{
+		TreeBranch branch = branches.back();
+		branches.pop_back();
+		if (branchMisses(shape, branch, rows, cols))
+			continue;
+
+		if (branch.depth == split)
+		{
+			jobs.push_back({ branch, order++ });
+			continue;
+		}
+
+		unsigned long long stamp = order++ << TREEORDERSHIFT;
+		growBranch(shape, branch, branches, [&](DrawPoint from, DrawPoint to)
+		{
+			rasterLine(rows, cols, from, to, [&](int col, int fromRow, int toRow, char ch)
+			{
+				stampColumn(stamps, rows, cols, col, fromRow, toRow, stamp | (unsigned char)ch);
+			});
+		});
+	}
+
+	runParallel(jobs.size(), threads, [&](size_t job)
+	{
+		thread_local vector<TreeBranch> jobBranches;
+		unsigned long long stamp = jobs[job].order << TREEORDERSHIFT;
+		walkTree(shape, jobs[job].branch, rows, cols, jobBranches, [&](DrawPoint from, DrawPoint to)
+		{
+			rasterLine(rows, cols, from, to, [&](int col, int fromRow, int toRow, char ch)
+			{
+				stamp += 1 << 8;
+				stampColumn(stamps, rows, cols, col, fromRow, toRow, stamp | (unsigned char)ch);
+			});
+		});
+	});
+
+	// Every thread has finished, so the stamps can be read without ordering
+	runParallel(rows, threads, [&](size_t row)
+	{
+		atomic<unsigned long long>* rowStamps = stamps + row * cols;
+		for (int col = 0; col < cols; col++)
+		{
+			unsigned long long stamp = rowStamps[col].load(memory_order_relaxed);
+			if (stamp != 0)
+			{
+				canvas[(int)row][col] = (char)(stamp & 0xFF);
+				rowStamps[col].store(0, memory_order_relaxed);
+			}
+		}
+	});
 }
 
 
 // Recursively draw nested boxes
-void drawBoxesRecursive(char canvas[][MAXCOLS], Point center, int height, bool animate)
+void drawBoxesRecursive(Canvas& canvas, Point center, int height, bool animate)
 {
 	//base case
 	if (height <= 1)
@@ -452,4 +1133,4 @@ void drawBoxesRecursive(char canvas[][MAXCOLS], Point center, int height, bool a
 	// Draw the box with the given height
 	drawBox(canvas, center, height, animate);
 	drawBoxesRecursive(canvas, center, height - 2, animate);
-}
\ No newline at end of file
+}
\ No newline at end of file
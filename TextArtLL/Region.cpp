@@ -0,0 +1,158 @@
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include "Definitions.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define REGION_SSE2
+#endif
+
+using namespace std;
+
+
+/**
+* Copies cells over out, keeping out's own cell wherever the copied one
+* is the transparent character.
+*
+* @param[in, out] out Cells to draw over
+* @param[in] cells Cells to draw
+* @param[in] length Number of cells
+* @param[in] transparent Character which lets out show through
+*/
+void blendCells(char* out, const char* cells, int length, char transparent)
+{
+	int x = 0;
+#ifdef REGION_SSE2
+	const __m128i clear = _mm_set1_epi8(transparent);
+	for (; x + 16 <= length; x += 16)
+	{
+		__m128i top = _mm_loadu_si128((const __m128i*)(cells + x));
+		__m128i below = _mm_loadu_si128((const __m128i*)(out + x));
+		__m128i showsBelow = _mm_cmpeq_epi8(top, clear);
+		_mm_storeu_si128((__m128i*)(out + x), _mm_or_si128(_mm_and_si128(showsBelow, below), _mm_andnot_si128(showsBelow, top)));
+	}
+#endif
+	for (; x < length; x++)
+	{
+		if (cells[x] != transparent)
+			out[x] = cells[x];
+	}
+}
+
+
+// Finds the part of the rectangle with corners a and b which lies on the canvas;
+// returns false if none of it does
+static bool clipRectangle(const Canvas& canvas, Point a, Point b, int& top, int& left, int& bottom, int& right)
+{
+	top = max(min(a.row, b.row), 0);
+	left = max(min(a.col, b.col), 0);
+	bottom = min(max(a.row, b.row), canvas.rows() - 1);
+	right = min(max(a.col, b.col), canvas.cols() - 1);
+	return top <= bottom && left <= right;
+}
+
+
+/**
+* Copies a rectangle of the canvas into the clipboard.
+*
+* @param[out] clipboard Canvas the size of the rectangle; empty if it misses the canvas
+* @param[in] canvas Canvas to copy from
+* @param[in] a One corner of the rectangle
+* @param[in] b The opposite corner
+*/
+bool copyRegion(Canvas& clipboard, const Canvas& canvas, Point a, Point b)
+{
+	int top, left, bottom, right;
+	if (!clipRectangle(canvas, a, b, top, left, bottom, right))
+	{
+		clipboard.resize(0, 0);
+		return false;
+	}
+
+	clipboard.resize(bottom - top + 1, right - left + 1);
+	for (int row = top; row <= bottom; row++)
+	{
+		memcpy(clipboard[row - top], canvas[row] + left, clipboard.cols());
+	}
+	return true;
+}
+
+
+/**
+* Copies a rectangle of the canvas into the clipboard and blanks it.
+*
+* @param[out] clipboard Canvas the size of the rectangle; empty if it misses the canvas
+* @param[in, out] canvas Canvas to cut from
+* @param[in] a One corner of the rectangle
+* @param[in] b The opposite corner
+*/
+bool cutRegion(Canvas& clipboard, Canvas& canvas, Point a, Point b)
+{
+	if (!copyRegion(clipboard, canvas, a, b))
+		return false;
+
+	int top, left, bottom, right;
+	clipRectangle(canvas, a, b, top, left, bottom, right);
+	for (int row = top; row <= bottom; row++)
+	{
+		memset(canvas[row] + left, ' ', right - left + 1);
+	}
+	return true;
+}
+
+
+/**
+* Draws the clipboard into the canvas, leaving out what falls off its edges.
+*
+* @param[in, out] canvas Canvas to paste into
+* @param[in] clipboard Cells to paste
+* @param[in] topLeft Where the top left cell of the clipboard goes; may be off the canvas
+* @param[in] opaque true: spaces are pasted too / false: they leave the canvas showing
+*/
+void pasteCanvas(Canvas& canvas, const Canvas& clipboard, Point topLeft, bool opaque)
+{
+	// The part of the clipboard which lands on the canvas
+	int firstRow = max(0, -topLeft.row);
+	int firstCol = max(0, -topLeft.col);
+	int lastRow = min(clipboard.rows(), canvas.rows() - topLeft.row);
+	int lastCol = min(clipboard.cols(), canvas.cols() - topLeft.col);
+	if (firstRow >= lastRow || firstCol >= lastCol)
+		return;
+
+	int length = lastCol - firstCol;
+	for (int row = firstRow; row < lastRow; row++)
+	{
+		char* out = canvas[topLeft.row + row] + topLeft.col + firstCol;
+		const char* cells = clipboard[row] + firstCol;
+		if (opaque)
+			memcpy(out, cells, length);
+		else
+			blendCells(out, cells, length, ' ');
+	}
+}
+
+
+/**
+* Loads a canvas file at its own size and pastes it into the canvas as a
+* sprite, with its spaces left out.
+*
+* @param[in, out] canvas Canvas to stamp into; left unchanged if the file cannot be read
+* @param[in] filename Path of the .txt or .rle file
+* @param[in] topLeft Where the top left cell of the sprite goes; may be off the canvas
+*/
+bool stampCanvas(Canvas& canvas, char filename[], Point topLeft)
+{
+	// Reused between calls, so stamping the same art again allocates nothing
+	thread_local Canvas sprite;
+	int rows, cols;
+	if (!canvasFileSize(filename, rows, cols))
+		return false;
+
+	sprite.resize(max(rows, 1), max(cols, 1));
+	if (!loadCanvas(sprite, filename))
+		return false;
+
+	pasteCanvas(canvas, sprite, topLeft, false);
+	return true;
+}
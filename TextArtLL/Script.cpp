@@ -0,0 +1,746 @@
+#include <iostream>
+#include <fstream>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Definitions.h"
+using namespace std;
+
+
+// Everything a script works on: the canvas, its layers once it has any,
+// the clips taken of it, the last rectangle copied and the drawing commands
+// run since the canvas was last started over or cleared. A batch run can
+// take hundreds of clips, so they are kept sparse, like the editor's.
+struct ScriptState
+{
+	Canvas canvas;
+	vector<TiledCanvas> clips;
+	Canvas clipboard;
+	LayerStack layers;
+	int currentLayer = -1;
+	DisplayList drawing;
+};
+
+
+// Number of words each command takes after its name, how many of them may be
+// left out, and whether the command draws into the current layer
+struct Command { const char* name; int words; int optional; bool draws; };
+static const Command COMMANDS[] =
+{
+	{ "canvas", 2, 0, false }, { "clear", 0, 0, true }, { "load", 1, 0, true }, { "save", 2, 1, false },
+	{ "move", 3, 1, true }, { "replace", 2, 0, true }, { "line", 4, 0, true }, { "box", 3, 0, true },
+	{ "boxes", 3, 0, true }, { "tree", 4, 0, true }, { "fill", 4, 1, true }, { "text", 3, 0, true },
+	{ "clip", 0, 0, false }, { "loadclips", 1, 0, false }, { "saveclips", 1, 0, false }, { "image", 2, 1, true },
+	{ "layer", 2, 1, false }, { "hide", 1, 0, false }, { "show", 1, 0, false },
+	{ "copy", 4, 0, true }, { "cut", 4, 0, true }, { "paste", 3, 1, true }, { "stamp", 3, 0, true },
+	{ "rotate", 2, 1, true }, { "mirror", 1, 0, true }, { "transpose", 1, 1, true },
+	{ "savelist", 1, 0, false }, { "drawlist", 1, 0, true },
+};
+
+// Names of the drawing commands, in the order of PrimitiveKind
+static const char* const PRIMITIVENAMES[] = { "line", "box", "boxes", "tree", "fill", "text" };
+
+
+// Splits a script line into words. Text in single or double quotes is one
+// word, so spaces can be given as ' '. A '#' outside quotes starts a comment.
+static bool splitWords(const string& line, vector<string>& words, string& error)
+{
+	words.clear();
+	size_t i = 0;
+	while (i < line.size())
+	{
+		if (isspace((unsigned char)line[i]))
+		{
+			i++;
+		}
+		else if (line[i] == '#')
+		{
+			break;
+		}
+		else if (line[i] == '\'' || line[i] == '"')
+		{
+			size_t close = line.find(line[i], i + 1);
+			if (close == string::npos)
+			{
+				error = "missing closing quote";
+				return false;
+			}
+			words.push_back(line.substr(i + 1, close - i - 1));
+			i = close + 1;
+		}
+		else
+		{
+			size_t end = i;
+			while (end < line.size() && !isspace((unsigned char)line[end]))
+				end++;
+			words.push_back(line.substr(i, end - i));
+			i = end;
+		}
+	}
+	return true;
+}
+
+
+// Reads words[index] as a whole number
+static bool readNumber(const vector<string>& words, size_t index, int& value, string& error)
+{
+	const char* text = words[index].c_str();
+	char* end;
+	long number = strtol(text, &end, 10);
+	if (*text == '\0' || *end != '\0')
+	{
+		error = "'" + words[index] + "' is not a number";
+		return false;
+	}
+	value = (int)number;
+	return true;
+}
+
+
+// Reads words[index] as a single character
+static bool readChar(const vector<string>& words, size_t index, char& ch, string& error)
+{
+	if (words[index].size() != 1)
+	{
+		error = "'" + words[index] + "' is not a single character";
+		return false;
+	}
+	ch = words[index][0];
+	return true;
+}
+
+
+// Copies a path word into a buffer the file functions take
+static bool readPath(const vector<string>& words, size_t index, char path[], string& error)
+{
+	if (words[index].size() >= FILENAMESIZE)
+	{
+		error = "path is too long";
+		return false;
+	}
+	snprintf(path, FILENAMESIZE, "%s", words[index].c_str());
+	return true;
+}
+
+
+// Lowercases the command name and finds the command; returns NULL and sets
+// error if there is no such command or it is given the wrong number of words
+static const Command* findCommand(vector<string>& words, string& error)
+{
+	string& name = words[0];
+	for (size_t i = 0; i < name.size(); i++)
+		name[i] = (char)tolower((unsigned char)name[i]);
+
+	const Command* command = NULL;
+	for (size_t i = 0; i < sizeof(COMMANDS) / sizeof(COMMANDS[0]); i++)
+	{
+		if (name == COMMANDS[i].name)
+			command = &COMMANDS[i];
+	}
+	if (command == NULL)
+	{
+		error = "unknown command '" + name + "'";
+		return NULL;
+	}
+
+	int given = (int)words.size() - 1;
+	if (given > command->words || given < command->words - command->optional)
+	{
+		error = name + " takes " + to_string(command->words) + " values";
+		return NULL;
+	}
+	return command;
+}
+
+
+// Returns the kind of primitive a command draws, or -1 if it is not a drawing command
+static int primitiveKind(const string& name)
+{
+	for (int i = 0; i < (int)(sizeof(PRIMITIVENAMES) / sizeof(PRIMITIVENAMES[0])); i++)
+	{
+		if (name == PRIMITIVENAMES[i])
+			return i;
+	}
+	return -1;
+}
+
+
+// Reads a drawing command which is known and has the right number of words
+static bool readPrimitive(const vector<string>& words, DrawPrimitive& primitive, string& error)
+{
+	int given = (int)words.size() - 1;
+	primitive = DrawPrimitive();
+	primitive.kind = (PrimitiveKind)primitiveKind(words[0]);
+	if (!readNumber(words, 1, primitive.a.row, error) || !readNumber(words, 2, primitive.a.col, error))
+		return false;
+
+	switch (primitive.kind)
+	{
+	case PRIMITIVELINE:
+		return readNumber(words, 3, primitive.b.row, error) && readNumber(words, 4, primitive.b.col, error);
+	case PRIMITIVEBOX:
+	case PRIMITIVEBOXES:
+		return readNumber(words, 3, primitive.size, error);
+	case PRIMITIVETREE:
+		return readNumber(words, 3, primitive.size, error) && readNumber(words, 4, primitive.angle, error);
+	case PRIMITIVEFILL:
+		if (!readChar(words, 3, primitive.ch, error))
+			return false;
+		if (given == 4 && words[4] != "diagonal")
+		{
+			error = "fill takes 'diagonal' as its option";
+			return false;
+		}
+		primitive.diagonal = given == 4;
+		return true;
+	case PRIMITIVETEXT:
+		primitive.text = words[3];
+		return true;
+	}
+	return true;
+}
+
+
+// Keeps a drawing command in the script's display list; the list starts
+// over whenever the canvas it draws into has changed size
+static void recordPrimitive(ScriptState& state, const Canvas& canvas, const DrawPrimitive& primitive)
+{
+	if (state.drawing.rows() != canvas.rows() || state.drawing.cols() != canvas.cols())
+		state.drawing.resize(canvas.rows(), canvas.cols());
+	state.drawing.add(primitive);
+}
+
+
+// Builds the path of text clip number of the set at path; a path cut short
+// would name another file, so it fails instead if the path is too long
+static bool clipFilePath(char clipPath[], const char path[], int number, string& error)
+{
+	int length = snprintf(clipPath, FILENAMESIZE, "%s-%d%s", path, number, TEXTEXTENSION);
+	if (length < 0 || length >= FILENAMESIZE)
+	{
+		error = "path is too long";
+		return false;
+	}
+	return true;
+}
+
+
+// Loads numbered text clips base-1.txt, base-2.txt, ... or one binary clip file
+static bool loadScriptClips(ScriptState& state, char path[], string& error)
+{
+	state.clips.clear();
+	if (isBinaryCanvasFile(path))
+	{
+		vector<Canvas> frames;
+		if (!loadFrames(frames, path) || frames.empty())
+		{
+			error = string("cannot read clips ") + path;
+			return false;
+		}
+		state.clips.resize(frames.size());
+		for (size_t i = 0; i < frames.size(); i++)
+			copyCanvas(state.clips[i], frames[i]);
+		return true;
+	}
+
+	char clipPath[FILENAMESIZE];
+	while (true)
+	{
+		if (!clipFilePath(clipPath, path, (int)state.clips.size() + 1, error))
+			return false;
+		Canvas clip(state.canvas.rows(), state.canvas.cols());
+		if (!loadCanvas(clip, clipPath))
+			break;
+		state.clips.emplace_back();
+		copyCanvas(state.clips.back(), clip);
+	}
+	if (state.clips.empty())
+	{
+		error = string("cannot read clips ") + path;
+		return false;
+	}
+	return true;
+}
+
+
+// Saves the clips as numbered text files, or as one binary clip file
+static bool saveScriptClips(const ScriptState& state, const char path[], string& error)
+{
+	if (isBinaryCanvasFile(path))
+	{
+		// The frames are diffed against each other, which needs whole rows
+		vector<Canvas> dense(state.clips.size());
+		vector<const Canvas*> frames;
+		for (size_t i = 0; i < state.clips.size(); i++)
+		{
+			copyCanvas(dense[i], state.clips[i]);
+			frames.push_back(&dense[i]);
+		}
+		if (!writeFramesFile(frames.data(), (int)frames.size(), path))
+		{
+			error = string("cannot write clips ") + path;
+			return false;
+		}
+		return true;
+	}
+
+	char clipPath[FILENAMESIZE];
+	for (size_t i = 0; i < state.clips.size(); i++)
+	{
+		if (!clipFilePath(clipPath, path, (int)i + 1, error))
+			return false;
+		if (!writeCanvasFile(state.clips[i], clipPath, false))
+		{
+			error = string("cannot write clips ") + path;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Runs a command which is known and has the right number of words; drawing
+// commands draw into canvas, which is the current layer if the script has layers
+static bool runCommandOn(ScriptState& state, Canvas& canvas, vector<string>& words, string& error)
+{
+	const string& name = words[0];
+	int given = (int)words.size() - 1;
+	char path[FILENAMESIZE];
+	int a, b, c, d;
+	char ch;
+
+	if (name == "canvas")
+	{
+		if (!readNumber(words, 1, a, error) || !readNumber(words, 2, b, error))
+			return false;
+		if (a < 1 || b < 1 || a > 0xFFFF || b > 0xFFFF)
+		{
+			error = "canvas size out of range";
+			return false;
+		}
+		canvas.resize(a, b);
+		state.layers.resize(0, 0);
+		state.currentLayer = -1;
+		state.drawing.resize(a, b);
+	}
+	else if (name == "clear")
+	{
+		initCanvas(canvas);
+		state.drawing.resize(canvas.rows(), canvas.cols());
+	}
+	else if (name == "load")
+	{
+		if (!readPath(words, 1, path, error))
+			return false;
+		if (!loadCanvas(canvas, path))
+		{
+			error = "cannot read " + words[1];
+			return false;
+		}
+	}
+	else if (name == "save")
+	{
+		if (!readPath(words, 1, path, error))
+			return false;
+		if (given == 2 && words[2] != "fixed")
+		{
+			error = "save takes 'fixed' as its option";
+			return false;
+		}
+		if (!writeCanvasFile(state.canvas, path, given == 2))
+		{
+			error = "cannot write " + words[1];
+			return false;
+		}
+	}
+	else if (name == "move")
+	{
+		if (!readNumber(words, 1, a, error) || !readNumber(words, 2, b, error))
+			return false;
+		if (given == 3 && words[3] != "wrap")
+		{
+			error = "move takes 'wrap' as its option";
+			return false;
+		}
+		moveCanvas(canvas, a, b, given == 3);
+	}
+	else if (name == "replace")
+	{
+		// Pairs up the characters of both words, like the editor's Replace
+		if (words[1].size() != words[2].size() || words[1].empty())
+		{
+			error = "replace needs two words of the same length";
+			return false;
+		}
+		char map[CHARSETSIZE];
+		initTranslation(map);
+		for (size_t i = 0; i < words[1].size(); i++)
+			map[(unsigned char)words[1][i]] = words[2][i];
+		translate(canvas, map);
+	}
+	else if (primitiveKind(name) >= 0)
+	{
+		DrawPrimitive primitive;
+		if (!readPrimitive(words, primitive, error))
+			return false;
+		drawPrimitive(canvas, primitive);
+		recordPrimitive(state, canvas, primitive);
+	}
+	else if (name == "image")
+	{
+		if (!readPath(words, 1, path, error))
+			return false;
+		if (!loadImageCanvas(canvas, path, given == 2 ? words[2].c_str() : DEFAULTRAMP, 1))
+		{
+			error = "cannot read image " + words[1];
+			return false;
+		}
+	}
+	else if (name == "copy" || name == "cut")
+	{
+		if (!readNumber(words, 1, a, error) || !readNumber(words, 2, b, error) ||
+			!readNumber(words, 3, c, error) || !readNumber(words, 4, d, error))
+			return false;
+		bool copied = name == "copy" ? copyRegion(state.clipboard, canvas, Point(a, b), Point(c, d)) :
+			cutRegion(state.clipboard, canvas, Point(a, b), Point(c, d));
+		if (!copied)
+		{
+			error = "the rectangle is off the canvas";
+			return false;
+		}
+	}
+	else if (name == "paste")
+	{
+		if (!readNumber(words, 1, a, error) || !readNumber(words, 2, b, error))
+			return false;
+		if (given == 3 && words[3] != "opaque")
+		{
+			error = "paste takes 'opaque' as its option";
+			return false;
+		}
+		if (state.clipboard.rows() == 0)
+		{
+			error = "nothing has been copied";
+			return false;
+		}
+		pasteCanvas(canvas, state.clipboard, Point(a, b), given == 3);
+	}
+	else if (name == "stamp")
+	{
+		if (!readPath(words, 1, path, error) || !readNumber(words, 2, a, error) || !readNumber(words, 3, b, error))
+			return false;
+		if (!stampCanvas(canvas, path, Point(a, b)))
+		{
+			error = "cannot read " + words[1];
+			return false;
+		}
+	}
+	else if (name == "rotate" || name == "transpose")
+	{
+		int option = name == "rotate" ? 2 : 1;
+		CanvasTransform transform = TRANSPOSE;
+		if (name == "rotate")
+		{
+			if (!readNumber(words, 1, a, error))
+				return false;
+			if (a != 90 && a != 180 && a != 270)
+			{
+				error = "rotate takes 90, 180 or 270 degrees";
+				return false;
+			}
+			transform = a == 90 ? ROTATE90 : a == 180 ? ROTATE180 : ROTATE270;
+		}
+		if (given == option && words[option] != "clip")
+		{
+			error = name + " takes 'clip' as its option";
+			return false;
+		}
+		transformCanvas(canvas, transform, given < option && state.currentLayer < 0);
+	}
+	else if (name == "mirror")
+	{
+		if (words[1] != "leftright" && words[1] != "topbottom")
+		{
+			error = "mirror takes leftright or topbottom";
+			return false;
+		}
+		transformCanvas(canvas, words[1] == "leftright" ? MIRRORLEFTRIGHT : MIRRORTOPBOTTOM, false);
+	}
+	else if (name == "clip")
+	{
+		state.clips.emplace_back();
+		copyCanvas(state.clips.back(), state.canvas);
+	}
+	else if (name == "layer")
+	{
+		if (given == 2 && !readChar(words, 2, ch, error))
+			return false;
+
+		// The first layer goes on top of what the canvas already shows
+		LayerStack& layers = state.layers;
+		if (layers.count() == 0)
+		{
+			layers.resize(canvas.rows(), canvas.cols());
+			int base = layers.addLayer("base", ' ');
+			copyCanvas(layers.beginEdit(base), canvas);
+			layers.endEdit(base);
+		}
+
+		state.currentLayer = layers.findLayer(words[1]);
+		if (state.currentLayer < 0)
+			state.currentLayer = layers.addLayer(words[1], given == 2 ? ch : ' ');
+		else if (given == 2)
+			layers.setTransparent(state.currentLayer, ch);
+		layers.composite(state.canvas);
+	}
+	else if (name == "hide" || name == "show")
+	{
+		int index = state.layers.findLayer(words[1]);
+		if (index < 0)
+		{
+			error = "no layer named '" + words[1] + "'";
+			return false;
+		}
+		state.layers.setVisible(index, name == "show");
+		state.layers.composite(state.canvas);
+	}
+	else if (name == "loadclips")
+	{
+		if (!readPath(words, 1, path, error))
+			return false;
+		if (!loadScriptClips(state, path, error))
+			return false;
+	}
+	else if (name == "saveclips")
+	{
+		if (!readPath(words, 1, path, error))
+			return false;
+		if (state.clips.empty())
+		{
+			error = "cannot write clips " + words[1];
+			return false;
+		}
+		if (!saveScriptClips(state, path, error))
+			return false;
+	}
+	else if (name == "savelist")
+	{
+		if (!saveDisplayList(state.drawing, words[1].c_str()))
+		{
+			error = "cannot write display list " + words[1];
+			return false;
+		}
+	}
+	else if (name == "drawlist")
+	{
+		DisplayList list;
+		string reason;
+		if (!loadDisplayList(list, words[1].c_str(), reason))
+		{
+			error = words[1] + ": " + reason;
+			return false;
+		}
+		list.rasterize(canvas);
+	}
+	return true;
+}
+
+
+// Runs one script command; returns false and sets error if it fails
+static bool runCommand(ScriptState& state, vector<string>& words, string& error)
+{
+	const Command* command = findCommand(words, error);
+	if (command == NULL)
+		return false;
+
+	// With layers, drawing goes into the current layer and the canvas shows them all
+	bool layered = command->draws && state.currentLayer >= 0;
+	Canvas& canvas = layered ? state.layers.beginEdit(state.currentLayer) : state.canvas;
+	bool done = runCommandOn(state, canvas, words, error);
+	if (layered)
+	{
+		state.layers.endEdit(state.currentLayer);
+		state.layers.composite(state.canvas);
+	}
+	return done;
+}
+
+
+/**
+* Runs a script read from a stream.
+*
+* @param script Script to run
+* @param[out] error Line number and reason, if the script stops on an error
+*/
+bool runScript(istream& script, string& error)
+{
+	ScriptState state;
+	state.canvas.resize(MAXROWS, MAXCOLS);
+	state.drawing.resize(MAXROWS, MAXCOLS);
+
+	string line;
+	vector<string> words;
+	for (int lineNumber = 1; getline(script, line); lineNumber++)
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+
+		string reason;
+		if (!splitWords(line, words, reason) || (!words.empty() && !runCommand(state, words, reason)))
+		{
+			error = "line " + to_string(lineNumber) + ": " + reason;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+* Runs the script in a file.
+*
+* @param filename Path of the script
+* @param[out] error Line number and reason, if the script stops on an error
+*/
+bool runScript(const char* filename, string& error)
+{
+	ifstream script(filename);
+	if (!script)
+	{
+		error = "cannot be read";
+		return false;
+	}
+	return runScript(script, error);
+}
+
+
+// Quotes a word for a script line with whichever quote it does not hold;
+// returns false if it holds both
+static bool quoteWord(const string& word, string& out)
+{
+	char quote = word.find('\'') == string::npos ? '\'' : '"';
+	if (word.find(quote) != string::npos)
+		return false;
+	out += quote;
+	out += word;
+	out += quote;
+	return true;
+}
+
+
+/**
+* Saves a display list as a script of drawing commands.
+*
+* @param[in] list List to save
+* @param filename Path of the file, used as given
+*/
+bool saveDisplayList(const DisplayList& list, const char* filename)
+{
+	string out = "canvas " + to_string(list.rows()) + " " + to_string(list.cols()) + "\n";
+	for (int i = 0; i < list.count(); i++)
+	{
+		const DrawPrimitive& primitive = list[i];
+		out += PRIMITIVENAMES[primitive.kind];
+		out += " " + to_string(primitive.a.row) + " " + to_string(primitive.a.col) + " ";
+		switch (primitive.kind)
+		{
+		case PRIMITIVELINE:
+			out += to_string(primitive.b.row) + " " + to_string(primitive.b.col);
+			break;
+		case PRIMITIVEBOX:
+		case PRIMITIVEBOXES:
+			out += to_string(primitive.size);
+			break;
+		case PRIMITIVETREE:
+			out += to_string(primitive.size) + " " + to_string(primitive.angle);
+			break;
+		case PRIMITIVEFILL:
+			quoteWord(string(1, primitive.ch), out);
+			if (primitive.diagonal)
+				out += " diagonal";
+			break;
+		case PRIMITIVETEXT:
+			if (!quoteWord(primitive.text, out))
+				return false;
+			break;
+		}
+		out += "\n";
+	}
+	return writeFileAtomic(filename, out.data(), out.size());
+}
+
+
+// Reads one line of a saved display list into list
+static bool readListLine(DisplayList& list, vector<string>& words, string& error)
+{
+	if (findCommand(words, error) == NULL)
+		return false;
+
+	if (words[0] == "canvas")
+	{
+		int rows, cols;
+		if (!readNumber(words, 1, rows, error) || !readNumber(words, 2, cols, error))
+			return false;
+		if (rows < 1 || cols < 1 || rows > 0xFFFF || cols > 0xFFFF)
+		{
+			error = "canvas size out of range";
+			return false;
+		}
+		if (list.count() > 0)
+		{
+			error = "canvas must come before the drawing commands";
+			return false;
+		}
+		list.resize(rows, cols);
+		return true;
+	}
+
+	DrawPrimitive primitive;
+	if (primitiveKind(words[0]) < 0)
+	{
+		error = words[0] + " is not a drawing command";
+		return false;
+	}
+	if (!readPrimitive(words, primitive, error))
+		return false;
+	list.add(primitive);
+	return true;
+}
+
+
+/**
+* Loads a display list from a script of drawing commands.
+*
+* @param[out] list List read; its primitives are replaced
+* @param filename Path of the file, used as given
+* @param[out] error Line number and reason, if a line cannot be read
+*/
+bool loadDisplayList(DisplayList& list, const char* filename, string& error)
+{
+	ifstream script(filename);
+	if (!script)
+	{
+		error = "cannot be read";
+		return false;
+	}
+
+	list.resize(0, 0);
+	string line;
+	vector<string> words;
+	for (int lineNumber = 1; getline(script, line); lineNumber++)
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+
+		string reason;
+		if (!splitWords(line, words, reason) || (!words.empty() && !readListLine(list, words, reason)))
+		{
+			error = "line " + to_string(lineNumber) + ": " + reason;
+			return false;
+		}
+	}
+	return true;
+}
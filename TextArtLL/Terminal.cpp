@@ -0,0 +1,467 @@
+#define NOMINMAX
+
+#include <iostream>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include "Definitions.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h>
+#else
+#include <csignal>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#endif
+
+using namespace std;
+
+
+// Output collected for the frame being built
+static string frameBuffer;
+
+// Number of beginFrame calls which have not been matched by endFrame yet
+static int frameDepth = 0;
+
+// false: frames are counted but not sent to the screen
+static bool frameOutput = true;
+
+static FrameStats stats;
+
+// Number of beginKeyInput calls which have not been matched by endKeyInput yet
+static int keyInputDepth = 0;
+
+
+//--------------------Windows console backend-----------------------------------------------------------
+#ifdef _WIN32
+
+// Writes to the console with one call; returns the number of bytes written, or -1
+static long writeScreen(const char* data, size_t length)
+{
+	static bool initialized = false;
+	HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	// The cursor is moved with ANSI escape sequences, which the console
+	// only understands once virtual terminal processing is turned on
+	if (!initialized)
+	{
+		DWORD mode = 0;
+		if (GetConsoleMode(out, &mode))
+			SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+		initialized = true;
+	}
+
+	DWORD written = 0;
+	if (!WriteFile(out, data, (DWORD)length, &written, NULL))
+		return -1;
+	return (long)written;
+}
+
+
+// _getch already reads single keys without echo
+static void setKeyInput(bool enabled)
+{
+}
+
+
+char getKey()
+{
+	beginKeyInput();
+	char key = (char)_getch();
+	endKeyInput();
+	return key;
+}
+
+
+bool escapePressed()
+{
+	return (GetKeyState(VK_ESCAPE) & 0x8000) != 0;
+}
+
+
+void pauseFor(int milliseconds)
+{
+	Sleep(milliseconds);
+}
+
+
+//--------------------POSIX terminal backend------------------------------------------------------------
+#else
+
+// Terminal settings to restore when key input ends
+static termios savedSettings;
+
+// A key code which getKey still has to return; -1 if none
+static int pendingKey = -1;
+
+// Time to wait for the rest of an escape sequence after ESC (in milliseconds)
+const int ESCAPEWAIT = 30;
+
+
+// Writes to the terminal with one call; returns the number of bytes written, or -1
+static long writeScreen(const char* data, size_t length)
+{
+	return (long)write(STDOUT_FILENO, data, length);
+}
+
+
+// Restores the terminal if the program ends during key input
+static void restoreTerminal()
+{
+	if (keyInputDepth > 0)
+		tcsetattr(STDIN_FILENO, TCSANOW, &savedSettings);
+}
+
+
+// Restores the terminal when a signal ends the program, which skips atexit,
+// then lets the signal end it as it would have. The settings saved last
+// are the ones the shell had, so restoring them after key input is harmless.
+static void restoreOnSignal(int signalNumber)
+{
+	tcsetattr(STDIN_FILENO, TCSANOW, &savedSettings);
+	signal(signalNumber, SIG_DFL);
+	raise(signalNumber);
+}
+
+
+// Switches the terminal between line input and single-key input without echo
+static void setKeyInput(bool enabled)
+{
+	if (!isatty(STDIN_FILENO))
+		return;
+
+	if (enabled)
+	{
+		tcgetattr(STDIN_FILENO, &savedSettings);
+
+		// Registered once there are settings to restore
+		static bool registered = false;
+		if (!registered)
+		{
+			atexit(restoreTerminal);
+			signal(SIGINT, restoreOnSignal);
+			signal(SIGTERM, restoreOnSignal);
+			signal(SIGHUP, restoreOnSignal);
+			registered = true;
+		}
+
+		termios raw = savedSettings;
+		raw.c_lflag &= ~(ICANON | ECHO);
+		raw.c_cc[VMIN] = 1;
+		raw.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+	}
+	else
+	{
+		tcsetattr(STDIN_FILENO, TCSANOW, &savedSettings);
+	}
+}
+
+
+// Reads one byte, waiting at most timeout milliseconds (-1: no limit); returns -1 if none
+static int readByte(int timeout)
+{
+	pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+	if (poll(&fd, 1, timeout) <= 0)
+		return -1;
+
+	unsigned char ch;
+	if (read(STDIN_FILENO, &ch, 1) != 1)
+		return -1;
+	return ch;
+}
+
+
+/*
+* Reads keys the way _getch does on Windows: an arrow key is returned as
+* SPECIAL followed by its arrow code on the next call, other special keys
+* as '\0' followed by a code which is ignored.
+*/
+char getKey()
+{
+	if (pendingKey >= 0)
+	{
+		char key = (char)pendingKey;
+		pendingKey = -1;
+		return key;
+	}
+
+	beginKeyInput();
+	int key = readByte(-1);
+
+	// Input closed or failed; treat it like ESC so input loops end
+	if (key < 0)
+		key = ESC;
+
+	// An escape sequence follows ESC immediately; a lone ESC is the key itself
+	if (key == ESC)
+	{
+		int next = readByte(ESCAPEWAIT);
+		if (next == '[' || next == 'O')
+		{
+			// Read up to the final byte of the sequence
+			int last = readByte(ESCAPEWAIT);
+			while (last >= 0 && (last < 0x40 || last > 0x7E))
+				last = readByte(ESCAPEWAIT);
+
+			key = '\0';
+			pendingKey = 0;
+			switch (last)
+			{
+			case 'A': key = SPECIAL; pendingKey = UPARROW; break;
+			case 'B': key = SPECIAL; pendingKey = DOWNARROW; break;
+			case 'C': key = SPECIAL; pendingKey = RIGHTARROW; break;
+			case 'D': key = SPECIAL; pendingKey = LEFTARROW; break;
+			}
+		}
+		else if (next >= 0)
+		{
+			// Alt + key; keep the key for the next call
+			pendingKey = next;
+		}
+	}
+	endKeyInput();
+
+	return (char)key;
+}
+
+
+/*
+* A terminal cannot tell whether a key is being held, so this returns
+* true if ESC was pressed since the last call.
+*/
+bool escapePressed()
+{
+	beginKeyInput();
+	bool pressed = false;
+	int key;
+	while ((key = readByte(0)) >= 0)
+	{
+		if (key == ESC)
+			pressed = true;
+	}
+	endKeyInput();
+	return pressed;
+}
+
+
+void pauseFor(int milliseconds)
+{
+	timespec time;
+	time.tv_sec = milliseconds / 1000;
+	time.tv_nsec = (milliseconds % 1000) * 1000000L;
+	nanosleep(&time, NULL);
+}
+
+#endif
+
+
+/**
+* Starts reading single keys without echo. Calls may be nested;
+* line input comes back when the outermost endKeyInput is called.
+*/
+void beginKeyInput()
+{
+	if (keyInputDepth++ == 0)
+		setKeyInput(true);
+}
+
+
+/**
+* Ends reading single keys.
+*/
+void endKeyInput()
+{
+	if (keyInputDepth > 0 && --keyInputDepth == 0)
+		setKeyInput(false);
+}
+
+
+/**
+* Clears the whole screen and moves the cursor to the top left corner.
+*/
+void clearScreen()
+{
+	frameWrite("\x1b[2J\x1b[H");
+	invalidateDisplay();
+}
+
+
+/**
+* Shows a message and waits until any key is pressed.
+*
+* @param message Text to show
+*/
+void waitForKey(const char* message)
+{
+	frameWrite(message);
+	getKey();
+}
+
+
+// Sends the collected output to the screen with a single write
+static void flushFrame()
+{
+	if (frameBuffer.empty())
+		return;
+
+	// Anything written with cout or printf has to reach the screen first
+	cout.flush();
+	fflush(stdout);
+
+	const char* data = frameBuffer.data();
+	size_t left = frameBuffer.size();
+	while (left > 0)
+	{
+		stats.writes++;
+		if (!frameOutput)
+			break;
+
+		long written = writeScreen(data, left);
+		if (written <= 0)
+			break;
+		data += written;
+		left -= written;
+	}
+
+	stats.bytes += frameBuffer.size();
+	stats.frames++;
+	frameBuffer.clear();
+}
+
+
+/**
+* Starts collecting output into a frame. Frames may be nested;
+* the output is sent when the outermost frame ends.
+*/
+void beginFrame()
+{
+	frameDepth++;
+}
+
+
+/**
+* Ends a frame. When the outermost frame ends, everything collected
+* is sent to the screen with one write.
+*/
+void endFrame()
+{
+	if (frameDepth > 0)
+		frameDepth--;
+
+	if (frameDepth == 0)
+		flushFrame();
+}
+
+
+/**
+* Adds text to the current frame.
+*
+* @param text Characters to add
+* @param length Number of characters to add
+*/
+void frameWrite(const char* text, size_t length)
+{
+	beginFrame();
+	frameBuffer.append(text, length);
+	endFrame();
+}
+
+
+/**
+* Adds a null-terminated string to the current frame.
+*
+* @param text String to add
+*/
+void frameWrite(const char* text)
+{
+	frameWrite(text, strlen(text));
+}
+
+
+/**
+* Adds printf-style formatted text to the current frame.
+*
+* @param format printf format string
+*/
+void framePrintf(const char* format, ...)
+{
+	char text[FRAMELINESIZE];
+
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	if (length > 0)
+		frameWrite(text, min(length, (int)sizeof(text) - 1));
+}
+
+
+/**
+* Returns the output totals since the program started
+* or since resetFrameStats was called.
+*/
+FrameStats frameStats()
+{
+	return stats;
+}
+
+
+/**
+* Sets the output totals back to zero.
+*/
+void resetFrameStats()
+{
+	stats = FrameStats();
+}
+
+
+/**
+* Chooses whether frames are sent to the screen or only counted.
+*
+* @param enabled true: send to the screen / false: only count
+*/
+void setFrameOutput(bool enabled)
+{
+	frameOutput = enabled;
+}
+
+
+/**
+* Moves the cursor in the output window to a specified row and column.
+* The next output produced by the program will begin at this position.
+*
+* @param row Row to move the cursor to
+* @param col Column to move the cursor to
+*/
+void gotoxy(short row, short col)
+{
+	// ANSI cursor position is 1-based
+	framePrintf("\x1b[%d;%dH", row + 1, col + 1);
+}
+
+
+/**
+* Clears a line on the output screen, then resets the cursor back to the
+* beginning of this line.
+*
+* @param lineNum Line number on the output screen to clear
+*/
+void clearLine(int lineNum)
+{
+	beginFrame();
+
+	// Move cursor to the beginning of the specified line on the console
+	gotoxy(lineNum, 0);
+
+	// Erase the whole line
+	frameWrite("\x1b[K");
+
+	endFrame();
+}
@@ -6,8 +6,11 @@
 #include <iostream>
 #include <fstream>
 #include <cctype>
-#include <windows.h>
-#include <conio.h>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <algorithm>
 #include "Definitions.h"
 using namespace std;
 
@@ -15,69 +18,112 @@ using namespace std;
 /**
 * @brief Main program allows display and editing of text art.
 *
+* Usage: TextArt [rows cols] [--timings FILE]
+* The canvas is MAXROWS x MAXCOLS unless another size is given.
+* With --timings, the latency of each operation is written to FILE on quit;
+* <T>imings writes the same report at any time.
+*
 * @return 0 if program will run succesfully.
 */
-int main()
+int main(int argc, char* argv[])
 {
 	const int FILESIZE = FILENAMESIZE - 15;
 	// char canvas[MAXROWS][MAXCOLS], 
 	//char undo[MAXROWS][MAXCOLS];
-	char old, newCh;
+	string oldChars, newChars;
 	char input;
 	char fileLoad[FILENAMESIZE];
-	int row, col;
+	int row, col, frames;
 	bool animate = false;
 	bool flag = true;
 	bool flagLoad = true;
 	char animateStatus;
 	//char menuMainTop[] = "<A>nimate: N / <U>ndo: 0 / Cl<I>p: 0\n";
 
-	char menuMainBottom[] = "<E>dit / <M>ove / <R>eplace / <D>raw / <C>lear / <U>ndo / <L>oad / <S>ave / <Q>uit: ";
+	char menuMainBottom[] = "<E>dit / <M>ove / <W>rap / <F>lip / <R>eplace / <D>raw / <C>lear / <U>ndo / <L>oad / <S>ave / <T>imings / <Q>uit: ";
+	int canvasRows = MAXROWS;
+	int canvasCols = MAXCOLS;
+	const char* timingsFile = NULL;
+	if (argc >= 3 && atoi(argv[1]) > 0 && atoi(argv[2]) > 0)
+	{
+		canvasRows = atoi(argv[1]);
+		canvasCols = atoi(argv[2]);
+	}
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--timings") == 0)
+			timingsFile = argv[i + 1];
+	}
+
 	//initCanvas(canvas);
-	Node* current = newCanvas();
-	Node* backUp = newCanvas(current);
+	Canvas current(canvasRows, canvasCols);
 	List undo;
 	List redo;
 	List clips;
+	// The last rectangle copied or cut in the drawing menu
+	Canvas clipboard;
 	//addNode(undo, backUp);
 	//initCanvas(undo);
 
+	clearScreen();
 	while (flag)
 	{
-		system("cls");
-		displayCanvas(current->item);
+		// A rotation, or undoing one, can change the size of the canvas;
+		// the menu moves with its bottom edge
+		if (current.rows() != canvasRows || current.cols() != canvasCols)
+		{
+			canvasRows = current.rows();
+			canvasCols = current.cols();
+			clearScreen();
+		}
+
+		// The cleared lines, canvas changes and menu go out as one frame
+		ScopedTimer display(TIMEDISPLAY);
+		beginFrame();
+
+		// Clear the menu and message lines; the canvas itself is only
+		// redrawn where it changed
+		for (int line = canvasRows + 1; line <= canvasRows + 4; line++)
+		{
+			clearLine(line);
+		}
+		displayCanvas(current);
 
 		animateStatus = animate ? 'Y' : 'N';
 
 
 		if (undo.count >= 0 && redo.count == 0 && clips.count < 2) //inital menu
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d \n", animateStatus, undo.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d \n", animateStatus, undo.count, clips.count);
 
 		}
 		if (clips.count >= 2 && redo.count == 0) // with just play
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undo.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undo.count, clips.count);
 		}
 		if (redo.count > 0 && clips.count < 2) // with just redo, if undo action was done
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d \n", animateStatus, undo.count, redo.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d \n", animateStatus, undo.count, redo.count, clips.count);
 		}
 		if (redo.count > 0 && clips.count >= 2) // with the redo and play option 
 		{
-			printf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undo.count, redo.count, clips.count);
+			framePrintf("<A>nimate: %c / <U>ndo: %d / Red<O>: %d / Cl<I>p: %d / <P>lay \n", animateStatus, undo.count, redo.count, clips.count);
 		}
 
 
 		//printf("%s", menuMainTop);
 		//printf("<A>nimate: %c / <U>ndo: %d %s%d / Cl<I>p: %d %s%c \n",animateStatus, undo.count,redoMenu, redo.count, clips.count, playMenu, playStatus);
-		printf("%s", menuMainBottom);
+		framePrintf("%s", menuMainBottom);
+		endFrame();
+		display.stop();
 
 		cin >> input;
-		clearLine(MAXROWS + 2, MAXCOLS + BUFFERSIZE);
-		clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+		clearLine(canvasRows + 2);
+		clearLine(canvasRows + 1);
 		input = toupper(input);
 
+		// Started by the operation chosen, once its prompts are answered
+		ScopedTimer timer;
 
 		switch (input)
 		{
@@ -85,10 +131,13 @@ int main()
 			animate = !animate;
 			break;
 		case 'O': //redo
+			timer.start(TIMEREDO);
 			restore(redo, undo, current);
 			break;
 		case 'I': //clips
-			addNode(clips, newCanvas(current));
+			// A clip the same as the last one is not added again
+			timer.start(TIMECLIP);
+			addClip(clips, current);
 			break;
 		case 'P':
 			play(clips);
@@ -96,37 +145,97 @@ int main()
 		case 'E':
 			printf("Press <ESC> to exit.");
 			addUndoState(undo, redo, current);
-			editCanvas(current->item);
+			editCanvas(current);
 			break;
 		case 'M':
 			printf("Enter column units to move: ");
 			cin >> col;
 			printf("Enter row units to move: ");
 			cin >> row;
+			timer.start(TIMEMOVE);
 			addUndoState(undo, redo, current);
-			moveCanvas(current->item, row, col);
+			moveCanvas(current, row, col);
 
+			break;
+		case 'W':
+			// Move with wrap-around; over several frames this makes a scrolling clip
+			printf("Enter column units to wrap: ");
+			cin >> col;
+			printf("Enter row units to wrap: ");
+			cin >> row;
+			printf("Enter number of frames (1 = wrap now): ");
+			cin >> frames;
+			timer.start(TIMEMOVE);
+			addUndoState(undo, redo, current);
+			if (frames > 1)
+			{
+				scrollClips(clips, current, row, col, frames, true);
+			}
+			else
+			{
+				moveCanvas(current, row, col, true);
+			}
+			break;
+		case 'F':
+			printf("Mirror <H>orizontally / <V>ertically, rotate <R>ight / <L>eft / <B>y 180, or <T>ranspose: ");
+			cin >> input;
+			input = toupper(input);
+			if (input == 'H' || input == 'V' || input == 'R' || input == 'L' || input == 'B' || input == 'T')
+			{
+				CanvasTransform transform = input == 'H' ? MIRRORLEFTRIGHT : input == 'V' ? MIRRORTOPBOTTOM :
+					input == 'R' ? ROTATE90 : input == 'L' ? ROTATE270 : input == 'B' ? ROTATE180 : TRANSPOSE;
+				bool resize = false;
+
+				// Turning a canvas which is not square on its side changes its shape
+				bool turns = input == 'R' || input == 'L' || input == 'T';
+				if (turns && canvasRows != canvasCols)
+				{
+					clearLine(canvasRows + 1);
+					printf("<R>esize the canvas to %d x %d, or <C>lip to %d x %d: ", canvasCols, canvasRows, canvasRows, canvasCols);
+					cin >> input;
+					input = toupper(input);
+					if (input != 'R' && input != 'C')
+						break;
+					resize = input == 'R';
+				}
+				timer.start(TIMETRANSFORM);
+				addUndoState(undo, redo, current);
+				transformCanvas(current, transform, resize);
+			}
 			break;
 		case 'D':
-			menuTwo(current, undo, redo, clips, animate);
+			menuTwo(current, undo, redo, clips, clipboard, animate);
 			break;
 		case 'C':
+			timer.start(TIMECLEAR);
 			addUndoState(undo, redo, current);
-			initCanvas(current->item);
+			initCanvas(current);
 			break;
 		case 'R':
-			printf("Enter character to replace: ");
-			cin.ignore(numeric_limits<streamsize>::max(), '\n');
-			cin.get(old);
-			printf("Enter character to replace with: ");
+			// Several characters can be replaced at once, e.g. "abc" with "xyz";
+			// if fewer replacements are given, the last one is used for the rest
+			printf("Enter characters to replace: ");
 			cin.ignore(numeric_limits<streamsize>::max(), '\n');
-			cin.get(newCh);
-			addUndoState(undo, redo, current);
-			replace(current->item, old, newCh);
+			getline(cin, oldChars);
+			printf("Enter characters to replace with: ");
+			getline(cin, newChars);
+			if (!oldChars.empty() && !newChars.empty())
+			{
+				char map[CHARSETSIZE];
+				initTranslation(map);
+				for (size_t i = 0; i < oldChars.size(); i++)
+				{
+					map[(unsigned char)oldChars[i]] = newChars[min(i, newChars.size() - 1)];
+				}
+				timer.start(TIMEREPLACE);
+				addUndoState(undo, redo, current);
+				translate(current, map);
+			}
 			break;
 		case 'U':
 			if (undo.count > 0)
 			{
+				timer.start(TIMEUNDO);
 				restore(undo, redo, current);
 			}
 			break;
@@ -138,40 +247,65 @@ int main()
 
 			if (input == 'C')
 			{
-				clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+				clearLine(canvasRows + 1);
 				cin.ignore();
-				cout << "Enter the filename (don't enter 'txt'): ";
+				cout << "Enter the filename (add '.rle' for binary, '.pgm' or '.ppm' for an image): ";
 				cin.getline(fileLoad, FILENAMESIZE);
-				char preFix[FILENAMESIZE] = "SavedFiles\\";
-				int length = 0;
+				char preFix[FILENAMESIZE] = "SavedFiles/";
 				int lengthP = strlen(preFix);
 
 
 
 				// Rewords the file name to be of use as a location in the SavedFiles folder
-				snprintf(preFix + lengthP, FILENAMESIZE - lengthP, "%s.txt", fileLoad);
+				bool image = isImageFile(fileLoad);
+				int written = snprintf(preFix + lengthP, FILENAMESIZE - lengthP, "%s%s", fileLoad, image || hasCanvasExtension(fileLoad) ? "" : TEXTEXTENSION);
+				if (written < 0 || written >= FILENAMESIZE - lengthP)
+				{
+					// A path cut short would load a different file
+					cerr << "ERROR: File name is too long\n";
+					break;
+				}
+				timer.start(TIMELOAD);
 				addUndoState(undo, redo, current);
-				flagLoad = loadCanvas(current->item, preFix);
+				LoadStats loadStats;
+
+				// Images are scaled to fill the canvas
+				if (image)
+					flagLoad = loadImageCanvas(current, preFix, DEFAULTRAMP, 0);
+				else
+					flagLoad = loadCanvas(current, preFix, loadStats);
+				timer.stop();
 				if (!flagLoad)
 				{
 					cerr << "ERROR: File cannot be read\n";
 				}
+				else if (loadStats.truncatedLines > 0 || loadStats.droppedLines > 0)
+				{
+					cerr << "WARNING: " << loadStats.truncatedLines << " lines cut at the right edge, "
+						<< loadStats.droppedLines << " lines below the bottom ignored\n";
+				}
 			}
 			else if (input == 'A')
 			{
-				clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
+				clearLine(canvasRows + 1);
 				cin.ignore();
-				cout << "Enter the filename (don't enter 'txt'): ";
+				cout << "Enter the filename (add '.rle' for binary): ";
 				cin.getline(fileLoad, FILENAMESIZE);
-				char preFix[FILENAMESIZE] = "SavedFiles\\";
-				int length = 0;
+				char preFix[FILENAMESIZE] = "SavedFiles/";
 				int lengthP = strlen(preFix);
 
 
 				// Rewords the file name to be of use as a location in the SavedFiles folder
-				snprintf(preFix + lengthP, FILENAMESIZE - lengthP, "%s", fileLoad);
+				int written = snprintf(preFix + lengthP, FILENAMESIZE - lengthP, "%s", fileLoad);
+				if (written < 0 || written >= FILENAMESIZE - lengthP)
+				{
+					cerr << "ERROR: File name is too long\n";
+					break;
+				}
 
-				flagLoad = loadClips(clips, preFix);
+				timer.start(TIMELOAD);
+				flagLoad = loadClips(clips, preFix, canvasRows, canvasCols);
+				timer.stop();
 
 				if (!flagLoad)
 				{
@@ -180,7 +314,7 @@ int main()
 				else
 				{
 					cout << "Clips loaded!\n";
-					system("pause");
+					waitForKey("Press any key to continue . . .");
 				}	
 				break;
 			}
@@ -193,12 +327,14 @@ int main()
 
 			if (input == 'C')
 			{
-				clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
-				cout << "Enter the name of the file: (don't enter 'txt')";
+				clearLine(canvasRows + 1);
+				cout << "Enter the name of the file (add '.rle' for binary): ";
 				cin.clear();
 				cin.ignore();
 				cin.getline(filename, FILENAMESIZE);
-				bool flagSave = saveCanvas(current->item, filename);
+				timer.start(TIMESAVE);
+				bool flagSave = saveCanvas(current, filename);
+				timer.stop();
 
 				if (!flagSave)
 				{
@@ -211,12 +347,14 @@ int main()
 			}
 			else if (input == 'A')
 			{
-				clearLine(MAXROWS + 1, MAXCOLS + BUFFERSIZE);
-				cout << "Enter the name of the file: (don't enter 'txt')";
+				clearLine(canvasRows + 1);
+				cout << "Enter the name of the file (add '.rle' for binary): ";
 				cin.clear();
 				cin.ignore();
 				cin.getline(filename, FILENAMESIZE);
+				timer.start(TIMESAVE);
 				bool flagSave = saveClips(clips, filename);
+				timer.stop();
 				if (!flagSave)
 				{
 					cerr << "ERROR" << endl;
@@ -224,333 +362,42 @@ int main()
 				else
 				{
 					cout << "Clips Saved!" << endl;
-					system("pause");
+					waitForKey("Press any key to continue . . .");
 				}
 				break;
 			}
 			break;
+		case 'T':
+			cout << "Enter the name of the file for the timings: ";
+			cin.ignore();
+			cin.getline(fileLoad, FILENAMESIZE);
+			if (!saveLatencyReport(fileLoad))
+			{
+				cerr << "ERROR" << endl;
+			}
+			else
+			{
+				cout << "Timings Saved!" << endl;
+				waitForKey("Press any key to continue . . .");
+			}
+			break;
 		case 'Q':
+			if (timingsFile != NULL && !saveLatencyReport(timingsFile))
+			{
+				cerr << "ERROR: timings cannot be written to " << timingsFile << endl;
+			}
 			deleteList(clips);
 			deleteList(redo);
 			deleteList(undo);
-			delete current;
 			flag = false;
 		default:
 			break;
 		}
 
-	}
-}
-
-
-/**
-* Moves the cursor in the output window to a specified row and column.
-* The next output produced by the program will begin at this position.
-*
-* @param row Row to move the cursor to
-* @param col Column to move the cursor to
-*/
-void gotoxy(short row, short col)
-{
-	COORD pos = { col, row };
-	SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), pos);
-}
-
-
-/**
-* Clears a line on the output screen, then resets the cursor back to the
-* beginning of this line.
-*
-* @param lineNum Line number on the output screen to clear
-* @param numOfChars Number of characters to clear on this line
-*/
-void clearLine(int lineNum, int numOfChars)
-{
-	// Move cursor to the beginning of the specified line on the console
-	gotoxy(lineNum, 0);
-
-	// Write a specified number of spaces to overwrite characters
-	for (int x = 0; x < numOfChars; x++)
-		cout << " ";
-
-	// Move cursor back to the beginning of the line
-	gotoxy(lineNum, 0);
-}
-
-
-/**
-* Replaces all instances of a character in the canvas.
-*
-* @param canvas[in] Array to update
-* @param oldCh The character to be replaced
-* @param newCh The character to replace with
-*/
-void replace(char canvas[][MAXCOLS], char oldCh, char newCh)
-{
-	for (int i = 0; i < MAXROWS; i++)
-	{
-		for (int j = 0; j < MAXCOLS; j++)
+		// Operations which changed nothing leave no undo state
+		if (flag)
 		{
-			if (canvas[i][j] == oldCh)
-			{
-				canvas[i][j] = newCh;
-			}
+			dropUnchangedUndoState(undo, current);
 		}
 	}
 }
-
-
-/**
-* Allows user to edit the canvas by moving the cursor
-* around and entering characters until ESC is pressed.
-*
-* @param[in] canvas Array that needs to be updated
-*/
-void editCanvas(char canvas[][MAXCOLS])
-{
-	char input = 0;
-	int row = 0, col = 0;
-
-	// Move cursor to row,col and then get
-	// a single character from the keyboard
-	gotoxy(row, col);
-
-	// Get input from user until ESC is pressed
-	while (input != ESC) {
-		input = _getch();
-
-		// Arrow keys
-		if (input == SPECIAL) {
-
-			input = _getch();
-
-			switch (input) {
-			case LEFTARROW:
-				if (col > 0) col--;
-				break;
-			case RIGHTARROW:
-				if (col < MAXCOLS - 1) col++;
-				break;
-			case UPARROW:
-				if (row > 0) row--;
-				break;
-			case DOWNARROW:
-				if (row < MAXROWS - 1) row++;
-				break;
-			default:
-				break;
-			}
-		}
-
-		// Ignore the function keys
-		else if (input == '\0') {
-			input = _getch();
-		}
-
-		// Printable ASCII characters
-		else if (input >= 32 && input <= 126) {
-			canvas[row][col] = input;
-			cout << input;
-		}
-
-		gotoxy(row, col); // Moves cursor to the new position
-	}
-}
-
-
-/**
-* Shifts contents of the canvas by a specified number of rows and columns.
-*
-* @param[in] canvas Canvas to update
-* @param rowValue Number of rows by which to shift
-* @param colValue Number of columns by which to shift
-*/
-void moveCanvas(char canvas[][MAXCOLS], int rowValue, int colValue)
-{
-	char temp[MAXROWS][MAXCOLS];
-	initCanvas(temp);
-	for (int x = 0; x < MAXROWS; x++)
-	{
-		if (x + rowValue < MAXROWS && x + rowValue >= 0)
-		{
-			for (int y = 0; y < MAXCOLS; y++)
-			{
-				if (y + colValue < MAXCOLS && y + colValue >= 0)
-				{
-					temp[x + rowValue][y + colValue] = canvas[x][y];
-					canvas[x][y] = ' ';
-				}
-			}
-		}
-	}
-	copyCanvas(canvas, temp);
-}
-
-
-/**
-* Initializes canvas to contain all spaces.
-*
-* @param canvas[in] Canvas to initialize
-*/
-void initCanvas(char canvas[][MAXCOLS])
-{
-	// Initializes spaces in all spots in array
-	for (int i = 0; i < MAXROWS; i++)
-	{
-		for (int j = 0; j < MAXCOLS; j++)
-		{
-			canvas[i][j] = ' ';
-		}
-	}
-}
-
-
-/**
-* Displays canvas contents on the screen, with a border
-* around the right and bottom edges.
-*
-* @param[in] Canvas to display
-*/
-void displayCanvas(char canvas[][MAXCOLS])
-{
-	gotoxy(0, 0);
-
-	for (int rowCount = 0; rowCount < MAXROWS; rowCount++)
-	{
-		for (int colCount = 0; colCount < MAXCOLS; colCount++)
-		{
-			cout << canvas[rowCount][colCount];        // Goes through and prints the array without any borders added 
-		}
-		cout << "|" << endl;    // Prints the right side of the border since when we reach this point colCount == MAXCOLS - 1
-
-	}
-
-	for (int bottomBorder = 0; bottomBorder < MAXCOLS; bottomBorder++)
-	{
-		cout << "-"; // Used to print the bottom border of the canvas.
-	}
-	cout << endl;
-}
-
-
-/**
-* Copies contents of the "from" canvas into the "to" canvas.
-*
-* @param[in] to Canvas to copy
-* @param[in] from Canvas to copy from
-*/
-void copyCanvas(char to[][MAXCOLS], char from[][MAXCOLS])
-{
-	for (int i = 0; i < MAXROWS; i++)
-	{
-		for (int j = 0; j < MAXCOLS; j++)
-		{
-			to[i][j] = from[i][j];
-		}
-	}
-}
-
-
-/**
-* Gets a filename from the user. If file can be opened for writing,
-* writes the canvas contents into the file.
-*
-* @param canvas[in] Canvas to save
-*/
-bool saveCanvas(char canvas[][MAXCOLS], char filename[])
-{
-	char directory[FILENAMESIZE] = "SavedFiles";    //Creates the directory used to make sure we have the correct filepath
-
-	char filePath[FILENAMESIZE];
-	snprintf(filePath, FILENAMESIZE, "%s\\%s.txt", directory, filename);
-	//Creates the filepath to be written into
-	ofstream myFile(filePath);
-	//checks if the file is open, writes the contents of canvas into it
-	if (myFile)
-	{
-		for (int x = 0; x < MAXROWS; x++)
-		{
-			for (int y = 0; y < MAXCOLS; y++)
-			{
-				myFile << canvas[x][y];
-			}
-			myFile << endl;
-		}
-		//closes the file and lets the user know that the file was saved.
-		myFile.close();
-		return true;
-	}
-	else
-	{
-		return false;
-	}
-}
-
-
-/**
-* Gets a filename from the user. If file can be opened for reading,
-* loads the file's contents into canvas.
-*
-* @param[in] canvas Canvas to load
-*/
-bool loadCanvas(char canvas[][MAXCOLS], char filename[])
-{
-	char buffer[BUFFERSIZE];
-
-	ifstream inFile;
-	inFile.open(filename);
-
-	// If the file can be found, go to the first position in the file and assigns all the characters
-	if (inFile)
-	{
-		initCanvas(canvas);
-
-		int c = inFile.get();
-		for (int row = 0; row <= MAXROWS + BUFFERSIZE && !inFile.eof();)
-		{
-			for (int col = 0; col <= MAXCOLS + BUFFERSIZE && !inFile.eof(); col++)
-			{
-				if (cin.fail())
-				{
-					cin.clear();
-					cin.ignore(numeric_limits<streamsize>::max(), '\n');
-				}
-				else
-				{
-					if (row < MAXROWS && col < MAXCOLS)
-					{
-						if (c == '\n')
-						{
-							row++;
-							col = -1;
-							c = inFile.get();
-						}
-						else
-						{
-							canvas[row][col] = c;
-							c = inFile.get();
-						}
-					}
-					else
-					{
-						while (c != '\n')
-						{
-							buffer[0] = c;
-							c = inFile.get();
-						}
-						row++;
-						col = -1;
-						c = inFile.get();
-					}
-				}
-			}
-		}
-		inFile.close();
-		return true;
-	}
-	else
-	{
-
-		return false;
-	}
-}
\ No newline at end of file
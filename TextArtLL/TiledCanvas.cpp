@@ -0,0 +1,379 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include "Definitions.h"
+using namespace std;
+
+
+// Cells of the tile shared by every blank part of every tiled canvas
+static const vector<char> blankTile(TILESIZE * TILESIZE, ' ');
+
+
+// Returns true if the len characters starting at p are all spaces
+static bool isBlank(const char* p, int len)
+{
+	return len <= 0 || (p[0] == ' ' && memcmp(p, p + 1, len - 1) == 0);
+}
+
+
+// Copies len characters into one row of a tiled canvas, starting at (row, col).
+// The span may cross tile boundaries, and pieces which are all spaces are skipped,
+// so the destination must be blank wherever the span lands.
+static void writeSpan(TiledCanvas& canvas, int row, int col, const char* src, int len)
+{
+	while (len > 0)
+	{
+		int tileCol = col / TILESIZE;
+		int offset = col % TILESIZE;
+		int piece = min(len, TILESIZE - offset);
+
+		if (!isBlank(src, piece))
+		{
+			char* tile = canvas.writableTile(row / TILESIZE, tileCol);
+			memcpy(tile + (row % TILESIZE) * TILESIZE + offset, src, piece);
+		}
+
+		src += piece;
+		col += piece;
+		len -= piece;
+	}
+}
+
+
+void TiledCanvas::set(int row, int col, char ch)
+{
+	int tileRow = row / TILESIZE;
+	int tileCol = col / TILESIZE;
+
+	// Writing a space into a blank tile changes nothing
+	if (ch == ' ' && !hasTile(tileRow, tileCol))
+		return;
+
+	writableTile(tileRow, tileCol)[(row % TILESIZE) * TILESIZE + col % TILESIZE] = ch;
+}
+
+
+const char* TiledCanvas::tile(int tileRow, int tileCol) const
+{
+	const vector<char>& t = tiles[tileRow * numTileCols + tileCol];
+	return t.empty() ? blankTile.data() : t.data();
+}
+
+
+char* TiledCanvas::writableTile(int tileRow, int tileCol)
+{
+	vector<char>& t = tiles[tileRow * numTileCols + tileCol];
+	if (t.empty())
+	{
+		t.assign(TILESIZE * TILESIZE, ' ');
+	}
+	return t.data();
+}
+
+
+void TiledCanvas::clear()
+{
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		vector<char>().swap(tiles[i]);
+	}
+}
+
+
+void TiledCanvas::resize(int rows, int cols)
+{
+	if (rows < 0) rows = 0;
+	if (cols < 0) cols = 0;
+
+	numRows = rows;
+	numCols = cols;
+	numTileRows = (rows + TILESIZE - 1) / TILESIZE;
+	numTileCols = (cols + TILESIZE - 1) / TILESIZE;
+
+	tiles.clear();
+	tiles.resize((size_t)numTileRows * numTileCols);
+}
+
+
+int TiledCanvas::allocatedTiles() const
+{
+	int count = 0;
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		if (!tiles[i].empty())
+			count++;
+	}
+	return count;
+}
+
+
+void initCanvas(TiledCanvas& canvas)
+{
+	canvas.clear();
+}
+
+
+void copyCanvas(TiledCanvas& to, const TiledCanvas& from)
+{
+	// Only the allocated tiles are copied
+	to = from;
+}
+
+
+void copyCanvas(TiledCanvas& to, const Canvas& from)
+{
+	to.resize(from.rows(), from.cols());
+
+	for (int row = 0; row < from.rows(); row++)
+	{
+		writeSpan(to, row, 0, from[row], from.cols());
+	}
+}
+
+
+void copyCanvas(Canvas& to, const TiledCanvas& from)
+{
+	if (to.rows() != from.rows() || to.cols() != from.cols())
+	{
+		to.resize(from.rows(), from.cols());
+	}
+	else
+	{
+		initCanvas(to);
+	}
+
+	for (int tileRow = 0; tileRow < from.tileRows(); tileRow++)
+	{
+		for (int tileCol = 0; tileCol < from.tileCols(); tileCol++)
+		{
+			if (!from.hasTile(tileRow, tileCol))
+				continue;
+
+			const char* tile = from.tile(tileRow, tileCol);
+			int col = tileCol * TILESIZE;
+			int width = min(TILESIZE, from.cols() - col);
+			int height = min(TILESIZE, from.rows() - tileRow * TILESIZE);
+
+			for (int r = 0; r < height; r++)
+			{
+				memcpy(to[tileRow * TILESIZE + r] + col, tile + r * TILESIZE, width);
+			}
+		}
+	}
+}
+
+
+void drawHelper(TiledCanvas& canvas, Point p, char ch, bool animate)
+{
+	// Pause time between steps (in milliseconds)
+	const int TIME = 50;
+
+	// Make sure point is within bounds
+	if (canvas.contains(p.row, p.col))
+	{
+		// Draw character into the canvas
+		canvas.set(p.row, p.col, ch);
+
+		// If animation is enabled, draw to screen at same time
+		if (animate)
+		{
+			beginFrame();
+			gotoxy(p.row, p.col);
+			frameWrite(&ch, 1);
+			endFrame();
+			pauseFor(TIME);
+		}
+	}
+}
+
+
+void translate(TiledCanvas& canvas, const char map[])
+{
+	bool spacesChange = map[(unsigned char)' '] != ' ';
+
+	// Tiles can only become blank if something is turned into spaces
+	bool makesSpaces = false;
+	for (int ch = 0; ch < CHARSETSIZE; ch++)
+	{
+		if (ch != ' ' && map[ch] == ' ')
+			makesSpaces = true;
+	}
+
+	for (int tileRow = 0; tileRow < canvas.tileRows(); tileRow++)
+	{
+		for (int tileCol = 0; tileCol < canvas.tileCols(); tileCol++)
+		{
+			// A blank tile can only change if spaces are being replaced
+			if (!canvas.hasTile(tileRow, tileCol) && !spacesChange)
+				continue;
+
+			char* tile = canvas.writableTile(tileRow, tileCol);
+			translateCells(tile, TILESIZE * TILESIZE, map);
+
+			// Keep memory proportional to the inked area
+			if (makesSpaces && !spacesChange && isBlank(tile, TILESIZE * TILESIZE))
+			{
+				canvas.releaseTile(tileRow, tileCol);
+			}
+		}
+	}
+
+	// The parts of edge tiles outside the canvas must stay blank
+	if (spacesChange)
+	{
+		int extraCols = canvas.tileCols() * TILESIZE - canvas.cols();
+		int extraRows = canvas.tileRows() * TILESIZE - canvas.rows();
+
+		for (int tileRow = 0; tileRow < canvas.tileRows(); tileRow++)
+		{
+			for (int tileCol = 0; tileCol < canvas.tileCols(); tileCol++)
+			{
+				bool lastRow = tileRow == canvas.tileRows() - 1;
+				bool lastCol = tileCol == canvas.tileCols() - 1;
+				if ((!lastRow || extraRows == 0) && (!lastCol || extraCols == 0))
+					continue;
+
+				char* tile = canvas.writableTile(tileRow, tileCol);
+				for (int r = 0; r < TILESIZE; r++)
+				{
+					if (lastRow && r >= TILESIZE - extraRows)
+						memset(tile + r * TILESIZE, ' ', TILESIZE);
+					else if (lastCol)
+						memset(tile + r * TILESIZE + TILESIZE - extraCols, ' ', extraCols);
+				}
+			}
+		}
+	}
+}
+
+
+void replace(TiledCanvas& canvas, char oldCh, char newCh)
+{
+	if (oldCh == newCh)
+		return;
+
+	char map[CHARSETSIZE];
+	initTranslation(map);
+	map[(unsigned char)oldCh] = newCh;
+	translate(canvas, map);
+}
+
+
+void moveCanvas(TiledCanvas& canvas, int rowValue, int colValue)
+{
+	TiledCanvas temp(canvas.rows(), canvas.cols());
+
+	for (int tileRow = 0; tileRow < canvas.tileRows(); tileRow++)
+	{
+		for (int tileCol = 0; tileCol < canvas.tileCols(); tileCol++)
+		{
+			if (!canvas.hasTile(tileRow, tileCol))
+				continue;
+
+			const char* tile = canvas.tile(tileRow, tileCol);
+
+			// Clip the tile's columns to the part still on the canvas after the shift
+			int firstCol = max(tileCol * TILESIZE, -colValue);
+			int lastCol = min(min((tileCol + 1) * TILESIZE, canvas.cols()), canvas.cols() - colValue);
+			if (firstCol >= lastCol)
+				continue;
+
+			for (int r = 0; r < TILESIZE; r++)
+			{
+				int row = tileRow * TILESIZE + r;
+				if (row >= canvas.rows())
+					break;
+				if (row + rowValue < 0 || row + rowValue >= canvas.rows())
+					continue;
+
+				const char* src = tile + r * TILESIZE + (firstCol - tileCol * TILESIZE);
+				writeSpan(temp, row + rowValue, firstCol + colValue, src, lastCol - firstCol);
+			}
+		}
+	}
+	canvas = move(temp);
+}
+
+
+bool sameCanvas(const TiledCanvas& a, uint64_t hashA, const Canvas& b, uint64_t hashB)
+{
+	if (hashA != hashB || a.rows() != b.rows() || a.cols() != b.cols())
+		return false;
+
+	// Blank tiles compare against the shared blank tile
+	for (int row = 0; row < a.rows(); row++)
+	{
+		for (int tileCol = 0; tileCol < a.tileCols(); tileCol++)
+		{
+			int col = tileCol * TILESIZE;
+			int width = min(TILESIZE, a.cols() - col);
+			const char* tile = a.tile(row / TILESIZE, tileCol);
+			if (memcmp(tile + (row % TILESIZE) * TILESIZE, b[row] + col, width) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+
+bool writeCanvasFile(const TiledCanvas& canvas, const char* path, bool fixedWidth)
+{
+	// The binary format encodes whole rows, which the dense canvas has ready
+	if (isBinaryCanvasFile(path))
+	{
+		Canvas dense;
+		copyCanvas(dense, canvas);
+		return writeCanvasFile(dense, path, fixedWidth);
+	}
+
+	string out;
+	string line(canvas.cols(), ' ');
+	for (int row = 0; row < canvas.rows(); row++)
+	{
+		// Blank tiles read from the shared blank tile
+		int inked = 0;
+		for (int tileCol = 0; tileCol < canvas.tileCols(); tileCol++)
+		{
+			int col = tileCol * TILESIZE;
+			int width = min(TILESIZE, canvas.cols() - col);
+			const char* tile = canvas.tile(row / TILESIZE, tileCol);
+			memcpy(&line[col], tile + (row % TILESIZE) * TILESIZE, width);
+
+			if (canvas.hasTile(row / TILESIZE, tileCol))
+				inked = col + width;
+		}
+
+		// Trailing spaces can only start in the last allocated tile
+		int length = canvas.cols();
+		if (!fixedWidth)
+		{
+			length = inked;
+			while (length > 0 && line[length - 1] == ' ')
+				length--;
+		}
+
+		out.append(line, 0, length);
+		out += '\n';
+	}
+	return writeFileAtomic(path, out.data(), out.size());
+}
+
+
+bool saveCanvas(const TiledCanvas& canvas, char filename[], bool fixedWidth)
+{
+	char filePath[FILENAMESIZE];
+	int length = snprintf(filePath, FILENAMESIZE, "SavedFiles/%s%s", filename, hasCanvasExtension(filename) ? "" : TEXTEXTENSION);
+	if (length < 0 || length >= FILENAMESIZE)
+	{
+		return false;
+	}
+
+	return writeCanvasFile(canvas, filePath, fixedWidth);
+}
+
+
+bool saveCanvas(const TiledCanvas& canvas, char filename[])
+{
+	return saveCanvas(canvas, filename, false);
+}
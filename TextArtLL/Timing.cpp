@@ -0,0 +1,183 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "Definitions.h"
+using namespace std;
+
+
+// Names of the timed operations, in the order of TimedOperation
+static const char* const OPERATIONNAMES[TIMEDOPERATIONS] =
+{
+	"display", "load", "save", "move", "transform", "replace", "clear", "fill", "line", "box", "boxes", "tree",
+	"copy", "paste", "stamp", "undo", "redo", "clip", "play frame",
+};
+
+// Values below 2^LATENCYSUBBITS nanoseconds get a bucket each; above that,
+// each power of two is split into 2^LATENCYSUBBITS buckets of equal width
+const int LATENCYBUCKETS = (64 - LATENCYSUBBITS + 1) << LATENCYSUBBITS;
+
+// Counts per bucket, plus totals for the mean and the largest value. The
+// counters are only ever added to, so timers on several threads need no lock.
+struct LatencyHistogram
+{
+	atomic<unsigned long long> buckets[LATENCYBUCKETS];
+	atomic<unsigned long long> count;
+	atomic<unsigned long long> total;
+	atomic<unsigned long long> largest;
+};
+
+static LatencyHistogram histograms[TIMEDOPERATIONS];
+
+
+// Returns the number of the highest bit set in value, which must not be 0
+static int highestBit(unsigned long long value)
+{
+	int bit = 0;
+	for (int step = 32; step > 0; step /= 2)
+	{
+		if (value >> (bit + step))
+			bit += step;
+	}
+	return bit;
+}
+
+
+// Returns the bucket counting a value of nanos nanoseconds
+static int bucketOf(unsigned long long nanos)
+{
+	if (nanos < (1ULL << LATENCYSUBBITS))
+		return (int)nanos;
+
+	int shift = highestBit(nanos) - LATENCYSUBBITS;
+	return ((shift + 1) << LATENCYSUBBITS) + (int)((nanos >> shift) & ((1 << LATENCYSUBBITS) - 1));
+}
+
+
+// Returns the largest value, in nanoseconds, which falls into bucket
+static unsigned long long bucketLimit(int bucket)
+{
+	if (bucket < (1 << LATENCYSUBBITS))
+		return bucket;
+
+	int shift = (bucket >> LATENCYSUBBITS) - 1;
+	unsigned long long first = ((1ULL << LATENCYSUBBITS) + (bucket & ((1 << LATENCYSUBBITS) - 1))) << shift;
+	return first + (1ULL << shift) - 1;
+}
+
+
+/**
+* Adds one measurement to the histogram of an operation.
+*
+* @param operation Operation which was timed
+* @param nanos How long it took, in nanoseconds
+*/
+void recordLatency(TimedOperation operation, unsigned long long nanos)
+{
+	LatencyHistogram& histogram = histograms[operation];
+	histogram.buckets[bucketOf(nanos)].fetch_add(1, memory_order_relaxed);
+	histogram.count.fetch_add(1, memory_order_relaxed);
+	histogram.total.fetch_add(nanos, memory_order_relaxed);
+
+	unsigned long long largest = histogram.largest.load(memory_order_relaxed);
+	while (nanos > largest && !histogram.largest.compare_exchange_weak(largest, nanos, memory_order_relaxed))
+	{
+	}
+}
+
+
+void ScopedTimer::start(TimedOperation operation)
+{
+	timedOperation = operation;
+	running = true;
+	startTime = chrono::steady_clock::now().time_since_epoch().count();
+}
+
+
+void ScopedTimer::stop()
+{
+	if (!running)
+		return;
+
+	running = false;
+	chrono::steady_clock::duration elapsed(chrono::steady_clock::now().time_since_epoch().count() - startTime);
+	recordLatency(timedOperation, (unsigned long long)chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+}
+
+
+void resetLatencies()
+{
+	for (int i = 0; i < TIMEDOPERATIONS; i++)
+	{
+		LatencyHistogram& histogram = histograms[i];
+		for (int bucket = 0; bucket < LATENCYBUCKETS; bucket++)
+			histogram.buckets[bucket].store(0, memory_order_relaxed);
+		histogram.count.store(0, memory_order_relaxed);
+		histogram.total.store(0, memory_order_relaxed);
+		histogram.largest.store(0, memory_order_relaxed);
+	}
+}
+
+
+// Returns the value, in nanoseconds, which fraction of the measurements do not exceed
+static unsigned long long percentile(const LatencyHistogram& histogram, unsigned long long count, double fraction)
+{
+	unsigned long long wanted = (unsigned long long)(fraction * count + 0.5);
+	if (wanted < 1)
+		wanted = 1;
+
+	unsigned long long seen = 0;
+	for (int bucket = 0; bucket < LATENCYBUCKETS; bucket++)
+	{
+		seen += histogram.buckets[bucket].load(memory_order_relaxed);
+		if (seen >= wanted)
+			return min(bucketLimit(bucket), histogram.largest.load(memory_order_relaxed));
+	}
+	return histogram.largest.load(memory_order_relaxed);
+}
+
+
+/**
+* Writes a table of the latencies measured so far, one row per operation
+* which ran at least once, with times in microseconds.
+*
+* @param[out] out Text of the table
+*/
+void latencyReport(string& out)
+{
+	char line[FRAMELINESIZE];
+	snprintf(line, sizeof(line), "%-12s %8s %10s %10s %10s %10s %10s %10s\n",
+		"operation", "count", "mean us", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+	out = line;
+
+	for (int i = 0; i < TIMEDOPERATIONS; i++)
+	{
+		const LatencyHistogram& histogram = histograms[i];
+		unsigned long long count = histogram.count.load(memory_order_relaxed);
+		if (count == 0)
+			continue;
+
+		snprintf(line, sizeof(line), "%-12s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", OPERATIONNAMES[i], count,
+			histogram.total.load(memory_order_relaxed) / 1000.0 / count,
+			percentile(histogram, count, 0.5) / 1000.0, percentile(histogram, count, 0.9) / 1000.0,
+			percentile(histogram, count, 0.99) / 1000.0, percentile(histogram, count, 0.999) / 1000.0,
+			histogram.largest.load(memory_order_relaxed) / 1000.0);
+		out += line;
+	}
+}
+
+
+/**
+* Writes the latency table into a file.
+*
+* @param path Path of the file, used as given
+*/
+bool saveLatencyReport(const char* path)
+{
+	string report;
+	latencyReport(report);
+	return writeFileAtomic(path, report.data(), report.size());
+}
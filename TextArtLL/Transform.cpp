@@ -0,0 +1,219 @@
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include "Definitions.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SSE2
+#endif
+
+using namespace std;
+
+
+// Rows and columns of the squares a rotation is done in; a square of the
+// source and of the result both stay in the cache while it is copied
+const int TRANSFORMBLOCK = 32;
+
+
+// Copies length cells from in to out in reverse order; in and out must not overlap
+static void reverseCells(char* out, const char* in, int length)
+{
+	int x = 0;
+#ifdef TRANSFORM_SSE2
+	// Swap the bytes of each 16-bit word, then the words, then the halves
+	for (; x + 16 <= length; x += 16)
+	{
+		__m128i cells = _mm_loadu_si128((const __m128i*)(in + length - 16 - x));
+		cells = _mm_or_si128(_mm_slli_epi16(cells, 8), _mm_srli_epi16(cells, 8));
+		cells = _mm_shufflelo_epi16(cells, _MM_SHUFFLE(0, 1, 2, 3));
+		cells = _mm_shufflehi_epi16(cells, _MM_SHUFFLE(0, 1, 2, 3));
+		cells = _mm_shuffle_epi32(cells, _MM_SHUFFLE(1, 0, 3, 2));
+		_mm_storeu_si128((__m128i*)(out + x), cells);
+	}
+#endif
+	for (; x < length; x++)
+	{
+		out[x] = in[length - 1 - x];
+	}
+}
+
+
+// Mirrors the canvas left to right in place, one row at a time
+static void mirrorLeftRight(Canvas& canvas)
+{
+	thread_local vector<char> row;
+	row.resize(canvas.cols());
+	for (int y = 0; y < canvas.rows(); y++)
+	{
+		memcpy(row.data(), canvas[y], canvas.cols());
+		reverseCells(canvas[y], row.data(), canvas.cols());
+	}
+}
+
+
+// Mirrors the canvas top to bottom in place, swapping whole rows
+static void mirrorTopBottom(Canvas& canvas)
+{
+	for (int top = 0, bottom = canvas.rows() - 1; top < bottom; top++, bottom--)
+	{
+		swap_ranges(canvas[top], canvas[top] + canvas.stride(), canvas[bottom]);
+	}
+}
+
+
+// Writes cell (row, col) of from into to at row firstRow + col * rowStep,
+// column firstCol + row * colStep, for the rows and columns of from given.
+// With steps of 1 or -1 this is a transpose, combined with a mirror of either side.
+static void turnCells(Canvas& to, const Canvas& from, int firstRow, int rowStep, int firstCol, int colStep,
+	int top, int bottom, int left, int right)
+{
+	ptrdiff_t step = rowStep * (ptrdiff_t)to.stride();
+	for (int row = top; row < bottom; row++)
+	{
+		// Reads go along a row of from, writes down a column of to
+		const char* in = from[row];
+		char* out = to[firstRow + left * rowStep] + firstCol + row * colStep;
+		for (int col = left; col < right; col++, out += step)
+			*out = in[col];
+	}
+}
+
+
+#ifdef TRANSFORM_SSE2
+// Transposes 16 x 16 cells: row i of the block starts at in + i * inStep, and
+// column j of it is written as the 16 cells from out + j * outStep
+static void transposeBlock(const char* in, ptrdiff_t inStep, char* out, ptrdiff_t outStep)
+{
+	__m128i cells[16], mixed[16];
+	for (int i = 0; i < 16; i++)
+		cells[i] = _mm_loadu_si128((const __m128i*)(in + i * inStep));
+
+	// Interleaving pairs of rows four times, at widths of 1, 2, 4 and 8
+	// bytes, leaves each column in one register
+	for (int k = 0; k < 8; k++)
+	{
+		mixed[k] = _mm_unpacklo_epi8(cells[2 * k], cells[2 * k + 1]);
+		mixed[k + 8] = _mm_unpackhi_epi8(cells[2 * k], cells[2 * k + 1]);
+	}
+	for (int k = 0; k < 8; k++)
+	{
+		cells[k] = _mm_unpacklo_epi16(mixed[2 * k], mixed[2 * k + 1]);
+		cells[k + 8] = _mm_unpackhi_epi16(mixed[2 * k], mixed[2 * k + 1]);
+	}
+	for (int k = 0; k < 8; k++)
+	{
+		mixed[k] = _mm_unpacklo_epi32(cells[2 * k], cells[2 * k + 1]);
+		mixed[k + 8] = _mm_unpackhi_epi32(cells[2 * k], cells[2 * k + 1]);
+	}
+	for (int k = 0; k < 8; k++)
+	{
+		cells[k] = _mm_unpacklo_epi64(mixed[2 * k], mixed[2 * k + 1]);
+		cells[k + 8] = _mm_unpackhi_epi64(mixed[2 * k], mixed[2 * k + 1]);
+	}
+
+	// Register i now holds the column whose number is i with its 4 bits reversed
+	static const int COLUMN[16] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+	for (int i = 0; i < 16; i++)
+		_mm_storeu_si128((__m128i*)(out + COLUMN[i] * outStep), cells[i]);
+}
+#endif
+
+
+// Turns all of from into to the way turnCells does, one TRANSFORMBLOCK
+// square at a time, using 16 x 16 transposes where whole ones fit
+static void turnCanvas(Canvas& to, const Canvas& from, int firstRow, int rowStep, int firstCol, int colStep)
+{
+	int blockRows = 0;
+	int blockCols = 0;
+#ifdef TRANSFORM_SSE2
+	blockRows = from.rows() / 16 * 16;
+	blockCols = from.cols() / 16 * 16;
+	ptrdiff_t inStep = colStep * (ptrdiff_t)from.stride();
+	ptrdiff_t outStep = rowStep * (ptrdiff_t)to.stride();
+	for (int top = 0; top < blockRows; top += TRANSFORMBLOCK)
+	{
+		for (int left = 0; left < blockCols; left += TRANSFORMBLOCK)
+		{
+			for (int row = top; row < min(top + TRANSFORMBLOCK, blockRows); row += 16)
+			{
+				// A mirrored side reads the rows of the block from the bottom up
+				int firstIn = colStep > 0 ? row : row + 15;
+				for (int col = left; col < min(left + TRANSFORMBLOCK, blockCols); col += 16)
+				{
+					transposeBlock(from[firstIn] + col, inStep,
+						to[firstRow + col * rowStep] + firstCol + firstIn * colStep, outStep);
+				}
+			}
+		}
+	}
+#endif
+
+	// The cells left over below and to the right of the whole transposes
+	for (int top = 0; top < from.rows(); top += TRANSFORMBLOCK)
+	{
+		int bottom = min(top + TRANSFORMBLOCK, from.rows());
+		for (int left = 0; left < from.cols(); left += TRANSFORMBLOCK)
+		{
+			int right = min(left + TRANSFORMBLOCK, from.cols());
+			if (top >= blockRows)
+			{
+				turnCells(to, from, firstRow, rowStep, firstCol, colStep, top, bottom, left, right);
+			}
+			else if (right > blockCols)
+			{
+				turnCells(to, from, firstRow, rowStep, firstCol, colStep, top, min(bottom, blockRows), max(left, blockCols), right);
+				if (bottom > blockRows)
+					turnCells(to, from, firstRow, rowStep, firstCol, colStep, blockRows, bottom, left, right);
+			}
+			else if (bottom > blockRows)
+			{
+				turnCells(to, from, firstRow, rowStep, firstCol, colStep, blockRows, bottom, left, right);
+			}
+		}
+	}
+}
+
+
+/**
+* Rotates, mirrors or transposes the canvas.
+*
+* @param[in, out] canvas Canvas to transform
+* @param transform How to move the cells
+* @param resize true: a canvas turned on its side swaps its rows and columns /
+*               false: it keeps its size, and the result is clipped to it
+*/
+void transformCanvas(Canvas& canvas, CanvasTransform transform, bool resize)
+{
+	if (transform == MIRRORLEFTRIGHT || transform == ROTATE180)
+		mirrorLeftRight(canvas);
+	if (transform == MIRRORTOPBOTTOM || transform == ROTATE180)
+		mirrorTopBottom(canvas);
+	if (transform != ROTATE90 && transform != ROTATE270 && transform != TRANSPOSE)
+		return;
+
+	// Reused between calls, so turning the same canvas again allocates nothing
+	thread_local Canvas turned;
+	int rows = canvas.rows();
+	int cols = canvas.cols();
+	turned.resize(cols, rows);
+
+	if (transform == TRANSPOSE)
+		turnCanvas(turned, canvas, 0, 1, 0, 1);
+	else if (transform == ROTATE90)
+		turnCanvas(turned, canvas, 0, 1, rows - 1, -1);
+	else
+		turnCanvas(turned, canvas, cols - 1, -1, 0, 1);
+
+	if (resize || rows == cols)
+	{
+		swap(canvas, turned);
+	}
+	else
+	{
+		// Keep the top left of the result, as much as fits
+		initCanvas(canvas);
+		pasteCanvas(canvas, turned, Point(0, 0), true);
+	}
+}
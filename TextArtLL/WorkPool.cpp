@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Definitions.h"
+using namespace std;
+
+
+// Jobs next to end - 1 which one thread still has to run
+struct WorkRange
+{
+	mutex lock;
+	size_t next = 0;
+	size_t end = 0;
+};
+
+
+// Takes the next job of a thread's own range; returns false if it is empty
+static bool takeJob(WorkRange& range, size_t& job)
+{
+	lock_guard<mutex> guard(range.lock);
+	if (range.next >= range.end)
+		return false;
+	job = range.next++;
+	return true;
+}
+
+
+// Moves the back half of victim's jobs into thief's empty range; returns false if victim has none
+static bool stealJobs(WorkRange& thief, WorkRange& victim)
+{
+	size_t begin, end;
+	{
+		lock_guard<mutex> guard(victim.lock);
+		if (victim.next >= victim.end)
+			return false;
+
+		// The victim keeps the front half, including the job it takes next
+		size_t left = victim.end - victim.next;
+		begin = victim.end - left / 2;
+		if (begin == victim.end)
+			begin = victim.next;
+		end = victim.end;
+		victim.end = begin;
+	}
+
+	lock_guard<mutex> guard(thief.lock);
+	thief.next = begin;
+	thief.end = end;
+	return true;
+}
+
+
+// Runs jobs from its own range, stealing from the others once it is empty
+static void runWorker(vector<WorkRange>& ranges, size_t self, const function<void(size_t)>& work)
+{
+	size_t job;
+	while (true)
+	{
+		while (takeJob(ranges[self], job))
+		{
+			work(job);
+		}
+
+		// No jobs are ever added, so once nobody has any left the work is done
+		bool stolen = false;
+		for (size_t i = 1; i < ranges.size() && !stolen; i++)
+		{
+			stolen = stealJobs(ranges[self], ranges[(self + i) % ranges.size()]);
+		}
+		if (!stolen)
+			return;
+	}
+}
+
+
+void runParallel(size_t jobs, int threads, const function<void(size_t job)>& work)
+{
+	if (threads <= 0)
+		threads = max(1, (int)thread::hardware_concurrency());
+	threads = (int)min((size_t)threads, max(jobs, (size_t)1));
+
+	// Give every thread an equal share to start with
+	vector<WorkRange> ranges(threads);
+	for (int t = 0; t < threads; t++)
+	{
+		ranges[t].next = jobs * t / threads;
+		ranges[t].end = jobs * (t + 1) / threads;
+	}
+
+	// The calling thread works too
+	vector<thread> workers;
+	for (int t = 1; t < threads; t++)
+	{
+		workers.push_back(thread(runWorker, ref(ranges), (size_t)t, cref(work)));
+	}
+	runWorker(ranges, 0, work);
+
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+}